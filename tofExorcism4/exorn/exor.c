@@ -37,6 +37,13 @@ float betaC = 1.0 ;
 int hasNots = 1 ;
 int costFunc = 0 ;
 int removeNots = 1 ;
+int optimizeGates = 1 ;
+// the number of alpha values in the sweep
+int nSweep = 1 ;
+// write the cascade as the binary gate list
+int fBinaryTfc = 0 ;
+// write the metrics of the cascade into the JSON file next to the TFC file
+int fMetricsFile = 0 ;
 
 // the function
 BFunc g_Func;
@@ -44,6 +51,12 @@ BFunc g_Func;
 // information about the cube cover
 cinfo g_CoverInfo;
 
+// the statistics written into the TFC files (one entry for each point of the sweep)
+tstats * g_pStats = NULL;
+
+// the name of the TFC file without the extension (if NULL, the input file name is used)
+char * g_FileTfc = NULL;
+
 ////////////////////////////////////////////////////////////////////////
 ///                       EXTERNAL FUNCTIONS                         ///
 ////////////////////////////////////////////////////////////////////////
@@ -58,6 +71,21 @@ extern void PrepareBitSetModule();
 // minimization
 extern int Exorcism();
 
+// the generator of the starting cover
+extern int CoverGenLookup( char * pName );
+
+// the wall-clock time
+extern double GetWallTime();
+
+// prints the progress of the minimization
+static int PrintProgress( int Round, int nCubes, int nLiterals, float Time );
+
+// reading and minimization of one file
+int MinimizeFile( DdManager * dd, char * FileName );
+
+// minimization of many files by the pool of workers
+extern int RunBatch( char ** pFiles, int nFiles, char * pFileList, int nWorkers, char * pDirOut, char * pFileCsv );
+
 
 ////////////////////////////////////////////////////////////////////////
 ///                        FUNCTION main()                           ///
@@ -69,14 +97,21 @@ int main( int argc, char* argv[] )
 	FILE * pFile;
 	DdManager * dd;
 	int RetValue;
-	long clk1;
+	char * pFileList = NULL;
+	char * pDirOut = NULL;
+	char * pFileCsv = NULL;
+	int nWorkers = 1;
 
 	// set the defaults
 	g_CoverInfo.Quality = 2;
 	g_CoverInfo.Verbosity = 0;
+	g_CoverInfo.QueBudget = QUEQUE_BUDGET;
+	g_CoverInfo.nThreads = 1;
+	g_CoverInfo.nPortfolio = 1;
+	g_CoverInfo.Verify = 1;
 
     util_getopt_reset();
-    while ((c = util_getopt(argc, argv, "q:v:a:b:n:c:r:")) != EOF) 
+    while ((c = util_getopt(argc, argv, "q:v:a:b:n:c:r:g:m:j:p:k:S:e:t:PC:Ns:BML:w:o:x:")) != EOF) 
 	{
 		switch(c) 
 		{
@@ -84,10 +119,10 @@ int main( int argc, char* argv[] )
 		  costFunc = atoi(util_optarg); //which cost function?
 		  break;
 		case 'a':
-		  alphaC = atoi(util_optarg); //alpha
+		  alphaC = atof(util_optarg); //alpha
 		  break;
 		case 'b':
-		  betaC = atoi(util_optarg); //beta
+		  betaC = atof(util_optarg); //beta
 		  break;		  
 		case 'n':
 		  hasNots = atoi(util_optarg); //use insert not algorithm
@@ -95,17 +130,86 @@ int main( int argc, char* argv[] )
 		case 'r':
 		  removeNots = atoi(util_optarg); //remove nots
 		  break;
+		case 'g':
+		  optimizeGates = atoi(util_optarg); //peephole optimization of the gates
+		  break;
 		case 'q':
 		  g_CoverInfo.Quality = atoi(util_optarg);
 		  break;
 		case 'v':
 		  g_CoverInfo.Verbosity = atoi(util_optarg);
 		  break;
+		case 'm':
+		  g_CoverInfo.QueBudget = atoi(util_optarg);
+		  break;
+		case 'j':
+		  g_CoverInfo.nThreads = atoi(util_optarg);
+		  break;
+		case 'p':
+		  g_CoverInfo.nPortfolio = atoi(util_optarg);
+		  break;
+		case 'k':
+		  g_CoverInfo.nClusterJobs = atoi(util_optarg); //the clusters of outputs
+		  break;
+		case 'S':
+		  g_CoverInfo.CoverGen = CoverGenLookup(util_optarg); //the starting cover
+		  if ( g_CoverInfo.CoverGen < 0 )
+		  {
+			  fprintf( stderr, "Unknown starting cover \"%s\"\n", util_optarg );
+			  goto usage;
+		  }
+		  break;
+		case 'e':
+		  g_CoverInfo.Verify = atoi(util_optarg); //verification of the cascade
+		  break;
+		case 't':
+		  g_CoverInfo.TimeLimit = atof(util_optarg); //the time limit of the job
+		  break;
+		case 'P':
+		  g_CoverInfo.pProgress = PrintProgress; //the progress after each round
+		  break;
+		case 'C':
+		  g_CoverInfo.pCacheDir = util_optarg; //the cache of the minimized covers
+		  break;
+		case 'N':
+		  g_CoverInfo.fClasses = 1; //minimize one output of each class
+		  break;
+		case 'B':
+		  fBinaryTfc = 1; //the binary gate list instead of the text
+		  break;
+		case 'M':
+		  fMetricsFile = 1; //the metrics into the JSON file
+		  break;
+		case 'L':
+		  pFileList = util_optarg; //the file with the list of input files
+		  break;
+		case 's':
+		  nSweep = atoi(util_optarg); //the number of alpha values in the sweep (see SweepPoints())
+		  break;
+		case 'w':
+		  nWorkers = atoi(util_optarg); //the number of worker processes
+		  break;
+		case 'o':
+		  pDirOut = util_optarg; //the directory for the TFC files
+		  break;
+		case 'x':
+		  pFileCsv = util_optarg; //the CSV file with the statistics
+		  break;
 		default:
 		  goto usage;
 		}
     }
 
+	if ( nSweep < 1 )
+		nSweep = 1;
+
+	// several files or the list of files are minimized in the batch mode
+	if ( argc - util_optind > 1 || pFileList || pDirOut || pFileCsv )
+	{
+		IntroduceYourself();
+		return RunBatch( argv + util_optind, argc - util_optind, pFileList, nWorkers, pDirOut, pFileCsv );
+	}
+
 	pFile = fopen( argv[util_optind], "r" );
 	if ( pFile == NULL )
 	{
@@ -118,11 +222,43 @@ int main( int argc, char* argv[] )
 	///////////////////////////////////////////////////////////////////////
 	// start the package
     dd = Cudd_Init( 0, 0, CUDD_UNIQUE_SLOTS, CUDD_CACHE_SLOTS, 0);
+
+	// general preparation
+	PrepareBitSetModule();
+
+	// read and minimize the function
+	RetValue = MinimizeFile( dd, argv[util_optind] );
+	if ( RetValue == 0 )
+		goto usage;
+	if ( RetValue == -1 )
+		return 0;
+
+	// shut down the package
+	Cudd_Quit( dd );
+	return 1;
+
+usage:
+	ExplainCommandLine(argv[0]);
+	return 0;
+}
+
+int MinimizeFile( DdManager * dd, char * FileName )
+// reads the function from the file, minimizes it, and writes the results
+// returns 1 on success, 0 if the file cannot be read, -1 if minimization failed
+{
+	int RetValue;
+	long clk1;
+
+	// the time limit applies to the whole job
+	g_CoverInfo.TimeBegin = GetWallTime();
+	g_CoverInfo.TimeStop = (g_CoverInfo.TimeLimit > 0)? g_CoverInfo.TimeBegin + g_CoverInfo.TimeLimit : 0;
+	g_CoverInfo.fStop = 0;
+
 	Cudd_AutodynEnable( dd, CUDD_REORDER_SYMM_SIFT );
 
 	// prepare the data structure that stores the multi-output function
 	// assign the initial parameters
-	g_Func.FileInput = strsav( argv[util_optind] );
+	g_Func.FileInput = strsav( FileName );
 	g_Func.dd = dd;
 
 	// call the input file reader	
@@ -134,7 +270,7 @@ int main( int argc, char* argv[] )
 	if ( Extra_ReadFile( &g_Func ) == 0 )
 	{
 		printf( "\nSomething did not work out while reading the input file\n");
-		goto usage;
+		return 0;
 	} 
 
 	// find the node count and path count in the shared BDD
@@ -170,12 +306,10 @@ int main( int argc, char* argv[] )
 	///////////////////////////////////////////////////////////////////////
 	// ESOP MINIMIZATION
 	///////////////////////////////////////////////////////////////////////
-	// general preparation
-	PrepareBitSetModule();
 	if ( Exorcism() == 0 )
 	{
 		printf( "Something went wrong when minimizing the cover\n" );
-		return 0;
+		return -1;
 	}
 //	if ( g_CoverInfo.Verbosity )
 //	printf( "Minimum cover has been written into file <%s>\n", g_Func.FileOutput );
@@ -190,19 +324,19 @@ int main( int argc, char* argv[] )
 		RetValue = Cudd_CheckZeroRef( dd );
 		printf( "\nThe number of referenced nodes = %d\n", RetValue );
 	}
-
-	// shut down the package
-	Cudd_Quit( dd );
 	return 1;
-
-usage:
-	ExplainCommandLine(argv[0]);
-	return 0;
 }
 
 
 
 
+static int PrintProgress( int Round, int nCubes, int nLiterals, float Time )
+{
+	printf( "Round %4d :  Cubes = %6d  Literals = %7d  Time = %7.2f sec\n", Round, nCubes, nLiterals, Time );
+	fflush( stdout );
+	return 1;
+}
+
 void IntroduceYourself()
 {
 	printf( "\nToffoli Cascade Gen, Ver.0.1" );
@@ -214,12 +348,13 @@ void IntroduceYourself()
 void ExplainCommandLine( char * ProgName )
 {
 	fprintf( stderr, "\n" );
-	fprintf( stderr, "Usage: %s [-q n] [-v n] file1\n", ProgName );
+	fprintf( stderr, "Usage: %s [-q n] [-v n] file1 [file2 ...]\n", ProgName );
 	fprintf( stderr, "\n" );
 	fprintf( stderr, "       Performs heuristic exclusive sum-of-project minimization and tfc cascade generation\n" );
 	fprintf( stderr, "\n" );
 	fprintf( stderr, "        -n {0,1} : insert nots = 1\n") ;
 	fprintf( stderr, "        -r {0,1} : remove nots = 1\n") ;
+	fprintf( stderr, "        -g {0,1} : remove the equal gates separated by commuting gates = 1\n") ;
 	fprintf( stderr, "        -a f : alpha\n") ;
 	fprintf( stderr, "        -b f : beta\n") ;
 	fprintf( stderr, "        -c {0,1} : cost function = 1\n") ;
@@ -227,10 +362,47 @@ void ExplainCommandLine( char * ProgName )
 	fprintf( stderr, "               increasing this number improves quality and adds to runtime\n");
 	fprintf( stderr, "        -v n : verbosity level [default = 0]\n");
 	fprintf( stderr, "               0 = no output; 1 = outline; 2 = verbose\n");
+	fprintf( stderr, "        -m n : memory budget for the cube pair queques, in Mb [default = %d]\n", QUEQUE_BUDGET);
+	fprintf( stderr, "        -j n : the number of threads computing the starting cover\n");
+	fprintf( stderr, "               and evaluating cube pairs [default = 1]\n");
+	fprintf( stderr, "               the result does not depend on this number\n");
+	fprintf( stderr, "        -t f : the time limit of the job in seconds [default = none]\n");
+	fprintf( stderr, "               the minimization stops after the ExorLink round that reaches\n");
+	fprintf( stderr, "               the limit, and the best cover found so far is used\n");
+	fprintf( stderr, "        -P : print the cubes and the literals after each ExorLink round\n");
+	fprintf( stderr, "        -C dir : the directory of the cache of the minimized covers [default = none]\n");
+	fprintf( stderr, "               the cover of a function minimized before with the same -q and -p\n");
+	fprintf( stderr, "               is read from the cache instead of being minimized again\n");
+	fprintf( stderr, "        -p n : the number of minimization runs with different strategies [default = 1]\n");
+	fprintf( stderr, "               the runs are performed in parallel and the best cover is kept\n");
+	fprintf( stderr, "        -k n : minimize the clusters of outputs with disjoint supports separately,\n");
+	fprintf( stderr, "               n clusters in parallel [default = 0 = all outputs together]\n");
+	fprintf( stderr, "        -S name : the starting cover of each output [default = pkrm]\n");
+	fprintf( stderr, "               pkrm = pseudo-Kronecker; isop = irredundant SOP (if disjoint);\n");
+	fprintf( stderr, "               dsop = disjoint SOP of the bdd paths; fprm = fixed-polarity Reed-Muller;\n");
+	fprintf( stderr, "               best = the cover with the fewest cubes among these\n");
+	fprintf( stderr, "        -N : minimize one output of each class of outputs equal up to the negation\n");
+	fprintf( stderr, "             of the inputs and the output, and derive the cubes of the other\n");
+	fprintf( stderr, "             outputs of the class by negating the literals of its cubes\n");
 	fprintf( stderr, "        file1: the input file in PLA (*.pla), ESOP (*.esop) or BLIF (*.blif)\n");
 	fprintf( stderr, "               the program detects the format from the file extension\n");
 	fprintf( stderr, "               in case of BLIF, minimization is applied the flattened network\n");
 	fprintf( stderr, "\n" );
+	fprintf( stderr, "        -s n : sweep n + 1 points: cost function 0 (file.c0.tfc) and cost function 1\n");
+	fprintf( stderr, "               with alpha = 0, 1/n, ..., (n-1)/n, beta = 1 - alpha (file.c1.a<alpha>.tfc);\n");
+	fprintf( stderr, "               the cover is minimized once and a TFC file is written for each point\n");
+	fprintf( stderr, "        -e n : verification of the Toffoli cascade [default = 1]\n");
+	fprintf( stderr, "               0 = none; 1 = simulation (exhaustive up to 16 inputs, random otherwise);\n");
+	fprintf( stderr, "               2 = equivalence check of the output bdds of the cascade\n");
+	fprintf( stderr, "        -B : write the cascade as the binary gate list (*.tfcb) instead of the text\n");
+	fprintf( stderr, "        -M : write the metrics of the cascade into the JSON file (*.tfc.json)\n");
+	fprintf( stderr, "\n" );
+	fprintf( stderr, "       Batch mode (several files, -L, -o or -x):\n" );
+	fprintf( stderr, "        -L file : the file with the list of input files (one per line)\n");
+	fprintf( stderr, "        -w n : the number of worker processes [default = 1]\n");
+	fprintf( stderr, "        -o dir : the directory for the TFC files [default = next to the input]\n");
+	fprintf( stderr, "        -x file : the CSV file with the statistics of all jobs [default = batch.csv]\n");
+	fprintf( stderr, "\n" );
 }
 
 	//////////////////////////////////////////////////////////////////////////
@@ -30,10 +30,22 @@
 ///                       MACRO DEFINITIONS                          ///
 ////////////////////////////////////////////////////////////////////////
 
-// the number of bits per integer (can be 16, 32, 64 - tested for 32)
+// the number of bits per integer (can be 32 or 64 - tested for both)
+// to compile with 64-bit words, add -DBPI=64 to CFLAGS
+#ifndef BPI
 #define BPI                 32 
+#endif
+
+#if BPI == 64
+#define BPIMASK             63 
+#define LOGBPI               6
+#elif BPI == 32
 #define BPIMASK             31 
 #define LOGBPI               5
+#else
+#define BPIMASK             15 
+#define LOGBPI               4
+#endif
 
 // the maximum number of input variables
 #define MAXVARS           1000
@@ -43,11 +55,20 @@
 
 // the factor showing how many cube pairs will be allocated
 #define CUBE_PAIR_FACTOR    20
-// the following number of cube pairs are allocated:
-// nCubesAlloc/CUBE_PAIR_FACTOR
+// the following number of cube pairs are allocated in each queque
+// at the beginning: nCubesAlloc*CUBE_PAIR_FACTOR;
+// after that, the queques grow on demand until the memory budget is reached
+
+// the default memory budget for the cube pair queques (in megabytes)
+#define QUEQUE_BUDGET      512
+
+// the number of variable groups in the index of cubes used to find close cubes;
+// two cubes at distance D agree in at least (INDEX_GROUPS - D) groups,
+// so it should be more than the largest distance of interest (4)
+#define INDEX_GROUPS         8
 
 #if BPI == 64
-#define DIFFERENT   0x5555555555555555
+#define DIFFERENT   0x5555555555555555ULL
 #define BIT_COUNT(w)   (BitCount[(w)&0xffff] + BitCount[((w)>>16)&0xffff] + BitCount[((w)>>32)&0xffff] + BitCount[(w)>>48])
 #elif BPI == 32
 #define DIFFERENT   0x55555555
@@ -69,6 +90,11 @@
 
 typedef enum { MULTI_OUTPUT = 1, SINGLE_NODE, MULTI_NODE  } type;
 
+// the progress callback called after each round of ExorLink with the number
+// of the round, the cubes and the literals in the cover, and the time since
+// the job started (in seconds); returns 0 to stop the minimization
+typedef int (*tprogress)( int Round, int nCubes, int nLiterals, float Time );
+
 // infomation about the cover
 typedef struct cinfo_tag 
 {
@@ -82,31 +108,121 @@ typedef struct cinfo_tag
 	int nCubesFree;     // number of free cubes
 	int nLiteralsBefore;// number of literals before
 	int nLiteralsAfter; // number of literals before
-	int cIDs;           // the counter of cube IDs
+	unsigned cIDs;      // the counter of cube IDs (generation stamps)
 
 	int Verbosity;      // verbosity level
 	int Quality;        // quality
+	int QueBudget;      // memory budget for the cube pair queques (in Mb)
+	int nThreads;       // the number of threads (starting cover, cube pairs)
+	int nPortfolio;     // the number of minimization runs in the portfolio
+	int nClusterJobs;   // the number of clusters of outputs minimized at a time (0 = no clusters)
+	int CoverGen;       // the generator of the starting cover (see s_pCoverGenNames in "exorCover.c")
+	int Verify;         // verification of the Toffoli cascade (0 = none; 1 = simulation; 2 = bdds)
+	float TimeLimit;    // the time limit of the job in seconds (0 = no limit)
+	tprogress pProgress;// the progress callback (or NULL)
+	char * pCacheDir;   // the directory of the cache of the minimized covers (or NULL)
+	int fClasses;       // minimize one output of each class of outputs equal up to input/output negation
+
+	double TimeBegin;   // the wall-clock time when the job started
+	double TimeStop;    // the wall-clock time when the minimization stops (0 = never)
+	int fStop;          // set when the minimization stopped before converging
 
 	int TimeRead;       // reading time
 	int TimeStart;      // starting cover computation time
 	int TimeMin;        // pure minimization time
 } cinfo;
 
+// the statistics of the Toffoli cascade (StatSetOne and StatSetTwo of the TFC file)
+typedef struct tstats_tag 
+{
+	int nVarsIn;          // the number of inputs
+	int nVarsOut;         // the number of outputs
+	int nCubes;           // the number of cubes in the ESOP
+	long nGates;          // the number of Toffoli gates
+	long nNots;           // the number of NOT gates
+	long nGatesBefore;    // the number of Toffoli gates before the peephole optimization
+	long nNotsBefore;     // the number of NOT gates before the peephole optimization
+	double qCostBefore;   // the quantum cost before the peephole optimization
+	double qCost;         // the quantum cost
+	int nLines;           // the number of lines of the cascade
+	int Depth;            // the depth of the cascade
+	float esopTime;       // reading and ESOP minimization time
+	float reorderTime;    // cube reordering time
+	float notRemovalTime; // NOT gate removal time
+	float peepholeTime;   // the peephole optimization time
+	float toffoliTime;    // the total Toffoli cascade generation time
+	float totalTime;      // the total time
+	int fStopped;         // 1 if the minimization was stopped by the time limit
+} tstats;
+
 // representation of one cube (24 bytes + bit info)
+#if BPI == 64
+typedef unsigned long long word;
+#elif BPI == 32
 typedef unsigned int  word;
+#else
+typedef unsigned short word;
+#endif
 typedef unsigned char byte;
 typedef struct cube 
 {
   byte  fMark;        // the flag which is TRUE if the cubes is enabled
-  byte  ID;           // (almost) unique ID of the cube
+  unsigned ID;        // the generation stamp of the cube (0 for free cubes)
   short a;            // the number of literals
   short z;            // the number of 1's in the output part
   word* pCubeDataIn;  // a pointer to the bit string representing literals
   word* pCubeDataOut; // a pointer to the bit string representing literals
   struct cube* Prev;  // pointers to the previous/next cubes in the list/ring 
   struct cube* Next;
+  struct cubeidx* pIdx; // a pointer to the entry of the cube in the index
+  int   Pos;          // the position of the cube in the dense arrays of the list
 } Cube;
 
+// the entry of the cube in the index used to find close cubes
+typedef struct cubeidx
+{
+  unsigned Query;     // the number of the last query that has seen the cube
+  unsigned Hash[INDEX_GROUPS];           // the hash values of variable groups
+  struct cube* PrevH[INDEX_GROUPS];      // the previous/next cubes in the hash bins
+  struct cube* NextH[INDEX_GROUPS];
+} CubeIdx;
+
+// the Toffoli cascade; the lines are the input lines (x0, x1, ...) followed
+// by the output lines (f0, f1, ...); the "not" gates target the input lines
+// and have no controls, the other gates target the output lines
+typedef struct tcascade_tag
+{
+	int nLinesIn;       // the number of input lines
+	int nOutputs;       // the number of output lines
+	int nLines;         // the total number of lines
+	int nWords;         // the number of words in the control mask of one gate
+	int nGates;         // the number of gates
+	int nGatesAlloc;    // the number of allocated gates
+	int * pTargets;     // the target line of each gate
+	int * pnControls;   // the number of control lines of each gate
+	word * pControls;   // the control masks (nWords words for each gate)
+} tcascade;
+
+// the control mask of the gate and the test of one control line
+#define CascadeControls(p,g)      ((p)->pControls + (g)*(p)->nWords)
+#define CascadeHasControl(p,g,l)  ((CascadeControls(p,g)[(l)/BPI] >> ((l)%BPI)) & 1)
+
+// the number of gate sizes counted separately in the metrics
+// (the last entry counts the gates with this many lines or more)
+#define METRICS_SIZES       16
+
+// the metrics of the Toffoli cascade collected while the gates are written
+typedef struct tmetrics_tag
+{
+	int nLines;         // the number of lines
+	int nLinesIn;       // the number of input lines
+	long nGates;        // the number of gates (including the "not" gates)
+	long nNots;         // the number of "not" gates
+	double qCost;       // the NCV quantum cost
+	int Depth;          // the number of levels of the gates acting on disjoint lines
+	long nSizes[METRICS_SIZES+1]; // the number of gates with the given number of lines
+} tmetrics;
+
 
 ////////////////////////////////////////////////////////////////////////
 ///              VARVALUE and CUBEDIST enum typedefs                 ///
@@ -0,0 +1,409 @@
+////////////////////////////////////////////////////////////////////////
+///                                                                  ///
+///                  Implementation of EXORCISM - 4                  ///
+///              An Exclusive Sum-of-Product Minimizer               ///
+///               Alan Mishchenko  <alanmi@ee.pdx.edu>               ///
+///                                                                  ///
+////////////////////////////////////////////////////////////////////////
+///                                                                  ///
+///                          Batch Module                            ///
+///                                                                  ///
+///      1) collects the jobs (one job for each input file)          ///
+///      2) runs the jobs by the pool of worker processes            ///
+///      3) writes the statistics of all jobs into a CSV file        ///
+///                                                                  ///
+////////////////////////////////////////////////////////////////////////
+///   This software was tested with the BDD package "CUDD", v.2.3.0  ///
+///                          by Fabio Somenzi                        ///
+///                  http://vlsi.colorado.edu/~fabio/                ///
+////////////////////////////////////////////////////////////////////////
+
+#include "exor.h"
+#include "extra.h"
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/select.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+////////////////////////////////////////////////////////////////////////
+///                       EXTERNAL VARIABLES                         ///
+////////////////////////////////////////////////////////////////////////
+
+// the parameters of the Toffoli cascade generation
+extern float alphaC;
+extern float betaC;
+extern int costFunc;
+extern int nSweep;
+
+// the points of the sweep
+extern int  SweepPoints();
+extern void SweepSetPoint( int Point );
+
+// information about the options and the cover
+extern cinfo g_CoverInfo;
+
+// the statistics written into the TFC files
+extern tstats * g_pStats;
+// the name of the TFC file without the extension
+extern char * g_FileTfc;
+
+////////////////////////////////////////////////////////////////////////
+///                      EXTERNAL FUNCTIONS                          ///
+////////////////////////////////////////////////////////////////////////
+
+// preparation
+extern void PrepareBitSetModule();
+
+// reading and minimization of one file
+extern int MinimizeFile( DdManager * dd, char * FileName );
+
+////////////////////////////////////////////////////////////////////////
+///                    FUNCTIONS OF THIS MODULE                      ///
+////////////////////////////////////////////////////////////////////////
+
+// minimizes the files by the pool of workers
+// returns 1 if all jobs are done, 0 otherwise
+int RunBatch( char ** pFiles, int nFiles, char * pFileList, int nWorkers, char * pDirOut, char * pFileCsv );
+
+// collects the input files from the command line and from the list
+static char ** BatchCollectFiles( char ** pFiles, int nFiles, char * pFileList, int * pnFilesAll );
+// performs one job in the worker process and sends the statistics to the parent
+static void BatchRunJob( DdManager * dd, char * FileName, char * pDirOut, int fd );
+// reads the statistics sent by the worker until the worker closes the pipe
+static int BatchReceiveStats( int fd, char * pBuffer, int nBytes );
+// writes the statistics of all jobs into the CSV file
+static int BatchWriteCsv( char * pFileCsv, char ** pFilesAll, int nJobs, tstats * pStats, int * pfOkay );
+
+////////////////////////////////////////////////////////////////////////
+///                        STATIC VARIABLES                          ///
+////////////////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////////////////
+///                      FUNCTION DEFINITIONS                        ///
+////////////////////////////////////////////////////////////////////////
+
+// each job minimizes one file and writes the TFC files for all points
+// of the sweep (see WriteResultIntoFile()), so the statistics of SweepPoints()
+// points are received from each worker; the job runs in a worker process forked from
+// this process after the state shared by all jobs (the bit tables,
+// the BDD manager) has been prepared, so the workers do not repeat it;
+// because the minimizer keeps its state in static variables, every job
+// gets a fresh worker; the workers send the statistics through the pipes,
+// which the parent reads before waiting for the worker to exit (otherwise
+// a worker writing more than the pipe holds would never exit)
+
+int RunBatch( char ** pFiles, int nFiles, char * pFileList, int nWorkers, char * pDirOut, char * pFileCsv )
+{
+	DdManager * dd;
+	char ** pFilesAll;
+	int nFilesAll, nJobs, nRunning, nFailed;
+	int * pPids, * pFds, * pJobs, * pfOkay;
+	tstats * pStats;
+	int Pipe[2], Pid, Status;
+	int iJob, nFdMax, k;
+	fd_set Fds;
+	long clk1;
+
+	pFilesAll = BatchCollectFiles( pFiles, nFiles, pFileList, &nFilesAll );
+	if ( pFilesAll == NULL || nFilesAll == 0 )
+	{
+		printf( "\nThere are no input files\n" );
+		return 0;
+	}
+	if ( nWorkers < 1 )
+		nWorkers = 1;
+	nJobs = nFilesAll;
+
+	if ( pDirOut )
+		mkdir( pDirOut, 0777 );
+
+	pPids  = ALLOC( int, nWorkers );
+	pFds   = ALLOC( int, nWorkers );
+	pJobs  = ALLOC( int, nWorkers );
+	pStats = ALLOC( tstats, nJobs * SweepPoints() );
+	pfOkay = ALLOC( int, nJobs );
+	if ( pPids == NULL || pFds == NULL || pJobs == NULL || pStats == NULL || pfOkay == NULL )
+	{
+		printf( "\nUnexpected memory allocation problem. Quitting...\n" );
+		return 0;
+	}
+	for ( k = 0; k < nWorkers; k++ )
+		pPids[k] = 0;
+	for ( iJob = 0; iJob < nJobs; iJob++ )
+		pfOkay[iJob] = 0;
+
+	if ( g_CoverInfo.Verbosity )
+		printf( "\nMinimizing %d file(s) with %d sweep point(s) by %d worker(s)...\n", nFilesAll, SweepPoints(), nWorkers );
+
+	// prepare the state shared by all jobs
+	clk1 = clock();
+	PrepareBitSetModule();
+	dd = Cudd_Init( 0, 0, CUDD_UNIQUE_SLOTS, CUDD_CACHE_SLOTS, 0);
+
+	// run the jobs
+	nRunning = 0;
+	for ( iJob = 0; iJob < nJobs || nRunning > 0; )
+	{
+		// start the next job, if there is a free worker
+		if ( iJob < nJobs && nRunning < nWorkers )
+		{
+			for ( k = 0; pPids[k]; k++ );
+			// make sure the output printed so far is not repeated by the worker
+			fflush( stdout );
+			if ( pipe( Pipe ) == -1 )
+				break;
+			Pid = (int)fork();
+			if ( Pid == -1 )
+			{
+				close( Pipe[0] );
+				close( Pipe[1] );
+				break;
+			}
+			if ( Pid == 0 )
+			{ // the worker performs the job
+				close( Pipe[0] );
+				BatchRunJob( dd, pFilesAll[iJob], pDirOut, Pipe[1] );
+				// (exit, rather than _exit, because the TFC file should be flushed)
+				exit( 0 );
+			}
+			close( Pipe[1] );
+			pPids[k] = Pid;
+			pFds[k]  = Pipe[0];
+			pJobs[k] = iJob++;
+			nRunning++;
+			continue;
+		}
+
+		// wait for a worker to send its statistics
+		FD_ZERO( &Fds );
+		for ( nFdMax = -1, k = 0; k < nWorkers; k++ )
+			if ( pPids[k] )
+			{
+				FD_SET( pFds[k], &Fds );
+				if ( nFdMax < pFds[k] )
+					nFdMax = pFds[k];
+			}
+		if ( select( nFdMax + 1, &Fds, NULL, NULL, NULL ) == -1 )
+		{
+			if ( errno == EINTR )
+				continue;
+			break;
+		}
+		for ( k = 0; k < nWorkers && !(pPids[k] && FD_ISSET( pFds[k], &Fds )); k++ );
+		if ( k == nWorkers )
+			continue;
+		pfOkay[pJobs[k]] = BatchReceiveStats( pFds[k], (char *)(pStats + pJobs[k] * SweepPoints()), sizeof(tstats) * SweepPoints() );
+		close( pFds[k] );
+		waitpid( (pid_t)pPids[k], &Status, 0 );
+		pPids[k] = 0;
+		nRunning--;
+
+		if ( g_CoverInfo.Verbosity )
+		{
+			if ( pfOkay[pJobs[k]] )
+				printf( "Job %4d: %s  Cubes = %5d  Gates = %6ld\n", pJobs[k],
+					pFilesAll[pJobs[k]], pStats[pJobs[k] * SweepPoints()].nCubes, pStats[pJobs[k] * SweepPoints()].nGates );
+			else
+				printf( "Job %4d: %s  failed\n", pJobs[k], pFilesAll[pJobs[k]] );
+		}
+	}
+	if ( iJob < nJobs )
+		printf( "\nCannot start a worker process; %d job(s) are not done\n", nJobs - iJob );
+
+	// wait for the remaining workers (only if the pool could not be continued);
+	// the pipe is closed first, so that a worker writing into it is not blocked
+	for ( k = 0; k < nWorkers; k++ )
+		if ( pPids[k] )
+		{
+			close( pFds[k] );
+			waitpid( (pid_t)pPids[k], &Status, 0 );
+		}
+
+	Cudd_Quit( dd );
+
+	// write the statistics
+	for ( nFailed = 0, k = 0; k < nJobs; k++ )
+		nFailed += !pfOkay[k];
+	if ( pFileCsv == NULL )
+		pFileCsv = "batch.csv";
+	if ( !BatchWriteCsv( pFileCsv, pFilesAll, nJobs, pStats, pfOkay ) )
+		printf( "\nCannot open the CSV file <%s>\n", pFileCsv );
+	else if ( g_CoverInfo.Verbosity )
+		printf( "The statistics of %d job(s) have been written into file <%s>\n", nJobs, pFileCsv );
+	if ( nFailed )
+		printf( "\n%d job(s) failed\n", nFailed );
+	if ( g_CoverInfo.Verbosity )
+		printf( "The total batch time is %.2f sec\n", TICKS_TO_SECONDS(clock() - clk1) );
+
+	for ( k = 0; k < nFilesAll; k++ )
+		FREE( pFilesAll[k] );
+	FREE( pFilesAll );
+	FREE( pPids );
+	FREE( pFds );
+	FREE( pJobs );
+	FREE( pStats );
+	FREE( pfOkay );
+	return (int)( nFailed == 0 );
+}
+
+static char ** BatchCollectFiles( char ** pFiles, int nFiles, char * pFileList, int * pnFilesAll )
+// collects the input files given on the command line and listed in the file;
+// in the list, the empty lines and the lines starting with '#' are skipped
+{
+	char ** pFilesAll;
+	int nFilesAll, nFilesAlloc;
+	char Buffer[1000], * pBeg, * pEnd;
+	FILE * pFile;
+	int i;
+
+	nFilesAlloc = nFiles + 100;
+	pFilesAll = ALLOC( char *, nFilesAlloc );
+	if ( pFilesAll == NULL )
+		return NULL;
+	for ( nFilesAll = 0, i = 0; i < nFiles; i++ )
+		pFilesAll[nFilesAll++] = strsav( pFiles[i] );
+
+	if ( pFileList )
+	{
+		pFile = fopen( pFileList, "r" );
+		if ( pFile == NULL )
+		{
+			printf( "\nCannot open the file list <%s>\n", pFileList );
+			*pnFilesAll = nFilesAll;
+			return pFilesAll;
+		}
+		while ( fgets( Buffer, 1000, pFile ) )
+		{
+			// trim the white space
+			for ( pBeg = Buffer; *pBeg == ' ' || *pBeg == '\t'; pBeg++ );
+			for ( pEnd = pBeg + strlen(pBeg); pEnd > pBeg && (pEnd[-1] == '\n' || pEnd[-1] == '\r' || pEnd[-1] == ' ' || pEnd[-1] == '\t'); pEnd-- );
+			*pEnd = 0;
+			if ( *pBeg == 0 || *pBeg == '#' )
+				continue;
+			if ( nFilesAll == nFilesAlloc )
+			{
+				nFilesAlloc *= 2;
+				pFilesAll = REALLOC( char *, pFilesAll, nFilesAlloc );
+				if ( pFilesAll == NULL )
+				{
+					fclose( pFile );
+					return NULL;
+				}
+			}
+			pFilesAll[nFilesAll++] = strsav( pBeg );
+		}
+		fclose( pFile );
+	}
+	*pnFilesAll = nFilesAll;
+	return pFilesAll;
+}
+
+static void BatchRunJob( DdManager * dd, char * FileName, char * pDirOut, int fd )
+// performs one job in the worker process: minimizes the file, writes
+// the TFC files for all points of the sweep, and sends their statistics
+// to the parent (nothing is sent if the job failed)
+{
+	char Buffer[1000];
+	char * pName;
+
+	// derive the name of the TFC file (without the extension)
+	if ( pDirOut )
+	{
+		pName = strrchr( FileName, '/' );
+		pName = pName ? pName + 1 : FileName;
+		if ( snprintf( Buffer, sizeof(Buffer), "%s/%s", pDirOut, pName ) >= (int)sizeof(Buffer) )
+		{
+			printf( "\nThe name of the output file for <%s> is too long\n", FileName );
+			close( fd );
+			return;
+		}
+		g_FileTfc = Buffer;
+	}
+
+	// the workers are silent, unless the verbosity level is 2
+	if ( g_CoverInfo.Verbosity < 2 )
+	{
+		freopen( "/dev/null", "w", stdout );
+		freopen( "/dev/null", "w", stderr );
+		g_CoverInfo.Verbosity = 0;
+	}
+
+	// perform the job
+	g_pStats = ALLOC( tstats, SweepPoints() );
+	if ( g_pStats == NULL )
+	{
+		close( fd );
+		return;
+	}
+	memset( g_pStats, 0, sizeof(tstats) * SweepPoints() );
+	if ( MinimizeFile( dd, FileName ) == 1 )
+		write( fd, g_pStats, sizeof(tstats) * SweepPoints() );
+	close( fd );
+}
+
+static int BatchReceiveStats( int fd, char * pBuffer, int nBytes )
+// reads the statistics from the pipe until the worker closes it
+// (one read may return a part of them); returns 1 if exactly nBytes
+// have been received, 0 otherwise
+{
+	char Extra;
+	int nRead = 0, nDone;
+	while ( 1 )
+	{
+		if ( nRead < nBytes )
+			nDone = (int)read( fd, pBuffer + nRead, nBytes - nRead );
+		else
+			nDone = (int)read( fd, &Extra, 1 );
+		if ( nDone == -1 && errno == EINTR )
+			continue;
+		if ( nDone <= 0 )
+			break;
+		nRead += nDone;
+	}
+	return nRead == nBytes;
+}
+
+static int BatchWriteCsv( char * pFileCsv, char ** pFilesAll, int nJobs, tstats * pStats, int * pfOkay )
+// writes one line with the numbers of StatSetOne and StatSetTwo for each job
+// and each point of the sweep; returns 1 on success, 0 if the file cannot be opened
+{
+	FILE * pFile;
+	double Power;
+	int iJob, nDigits, i;
+	tstats * p;
+
+	pFile = fopen( pFileCsv, "w" );
+	if ( pFile == NULL )
+		return 0;
+	fprintf( pFile, "file,alpha,beta,cost,in,out,cubes,gates,nots,esopTime,reorderTime,notRemovalTime,toffoliTime,totalTime,"
+					"gatesBefore,notsBefore,qcostBefore,qcost,peepholeTime,lines,depth,status\n" );
+	// alpha is printed with the digits used in the names of the TFC files
+	for ( nDigits = 2, Power = 100.0; Power < nSweep; nDigits++, Power *= 10 );
+	for ( iJob = 0; iJob < nJobs; iJob++ )
+	for ( i = 0; i < SweepPoints(); i++ )
+	{
+		// the point of the cost function 0 does not depend on alpha and beta
+		SweepSetPoint( i );
+		if ( nSweep > 1 && costFunc == 0 )
+			fprintf( pFile, "%s,,,%d,", pFilesAll[iJob], costFunc );
+		else
+			fprintf( pFile, "%s,%.*f,%.*f,%d,", pFilesAll[iJob], nDigits, alphaC, nDigits, betaC, costFunc );
+		p = pStats + iJob * SweepPoints() + i;
+		if ( pfOkay[iJob] )
+			fprintf( pFile, "%d,%d,%d,%ld,%ld,%.2f,%.2f,%.2f,%.2f,%.2f,%ld,%ld,%.0f,%.0f,%.2f,%d,%d,%s\n",
+				p->nVarsIn, p->nVarsOut, p->nCubes, p->nGates, p->nNots, p->esopTime,
+				p->reorderTime, p->notRemovalTime, p->toffoliTime, p->totalTime,
+				p->nGatesBefore, p->nNotsBefore, p->qCostBefore, p->qCost, p->peepholeTime, p->nLines, p->Depth, p->fStopped? "timeout": "ok" );
+		else
+			fprintf( pFile, ",,,,,,,,,,,,,,,,,failed\n" );
+	}
+	fclose( pFile );
+	return 1;
+}
+
+///////////////////////////////////////////////////////////////////
+////////////              End of File             /////////////////
+///////////////////////////////////////////////////////////////////
@@ -19,11 +19,20 @@
 ////////////////////////////////////////////////////////////////////////
 
 #include "exor.h"
+#include <string.h>
 
 ////////////////////////////////////////////////////////////////////////
 ///                       MACRO DEFINITIONS                          ///
 ////////////////////////////////////////////////////////////////////////
 
+// the kernels using the hardware popcount (and AVX2 on 64-bit platforms)
+// are compiled with GCC-compatible compilers for x86; they are used only
+// if the processor supports them, which is checked at run time
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define USE_X86_KERNELS
+#include <immintrin.h>
+#endif
+
 ////////////////////////////////////////////////////////////////////////
 ///                       EXTERNAL VARIABLES                         ///
 ////////////////////////////////////////////////////////////////////////
@@ -40,12 +49,41 @@ extern cinfo g_CoverInfo;
 
 int GetDistance( Cube * pC1, Cube * pC2 );
 // return the distance between two cubes
+int GetDistanceBits( word * pIn1, word * pOut1, word * pIn2, word * pOut2 );
+// return the distance between two cubes given by their bit strings
+int ScanCloseCubes( Cube * p, int Dist, word * pArrIn, word * pArrOut, short * pArrLits, int iStart );
+// looks for a cube close to p in the dense arrays of cubes
 int GetDistancePlus( Cube * pC1, Cube * pC2 );
 
 int FindDiffVars( int * pDiffVars, Cube * pC1, Cube * pC2 );
 // determine different variables in cubes from pCubes[] and writes them into pDiffVars
 // returns the number of different variables
 
+void SelectDistanceKernels( int nWordsIn );
+// selects the fastest cube distance kernels for the given cube size
+
+// the kernels counting the different variables in the input parts of two cubes
+// (return the number of different variables, or 5 if there are more than 4)
+static int CountDiffVarsTable( word * pIn1, word * pIn2, int nWords );
+#ifdef USE_X86_KERNELS
+static int CountDiffVarsPopcnt( word * pIn1, word * pIn2, int nWords );
+#ifdef __x86_64__
+static int CountDiffVarsAvx2( word * pIn1, word * pIn2, int nWords );
+#endif
+#endif
+
+// the kernels scanning the dense arrays of cubes
+static int ScanCloseCubesTable( Cube * p, int Dist, word * pArrIn, word * pArrOut, short * pArrLits, int iStart );
+#ifdef USE_X86_KERNELS
+static int ScanCloseCubesPopcnt( Cube * p, int Dist, word * pArrIn, word * pArrOut, short * pArrLits, int iStart );
+#endif
+
+// the kernels finding the different variables in two cubes
+static int FindDiffVarsTable( int * pDiffVars, Cube * pC1, Cube * pC2 );
+#ifdef USE_X86_KERNELS
+static int FindDiffVarsPopcnt( int * pDiffVars, Cube * pC1, Cube * pC2 );
+#endif
+
 void InsertVars( Cube * pC, int * pVars, int nVarsIn, int * pVarValues );
 void InsertVarsWithoutClearing( Cube * pC, int * pVars, int nVarsIn, int * pVarValues, int Output );
 
@@ -123,6 +161,11 @@ static unsigned char GroupLiterals[163][4] = {
 static unsigned char BitGroupNumbers[FULL16BITS];
 unsigned char BitCount[FULL16BITS];
 
+// the kernels selected for this processor
+static int (*s_pCountDiffVars)( word * pIn1, word * pIn2, int nWords ) = CountDiffVarsTable;
+static int (*s_pFindDiffVars)( int * pDiffVars, Cube * pC1, Cube * pC2 ) = FindDiffVarsTable;
+static int (*s_pScanCloseCubes)( Cube * p, int Dist, word * pArrIn, word * pArrOut, short * pArrLits, int iStart ) = ScanCloseCubesTable;
+
 ////////////////////////////////////////////////////////////////////////
 ///                      FUNCTION DEFINITIONS                        ///
 ////////////////////////////////////////////////////////////////////////
@@ -156,6 +199,44 @@ void PrepareBitSetModule()
 */
 }
 
+void SelectDistanceKernels( int nWordsIn )
+// selects the cube distance kernels supported by the processor;
+// this function should be called when the number of words in the cube is known
+{
+	s_pCountDiffVars  = CountDiffVarsTable;
+	s_pFindDiffVars   = FindDiffVarsTable;
+	s_pScanCloseCubes = ScanCloseCubesTable;
+#ifdef USE_X86_KERNELS
+	__builtin_cpu_init();
+	if ( __builtin_cpu_supports( "popcnt" ) )
+	{
+		s_pCountDiffVars  = CountDiffVarsPopcnt;
+		s_pFindDiffVars   = FindDiffVarsPopcnt;
+		s_pScanCloseCubes = ScanCloseCubesPopcnt;
+	}
+#ifdef __x86_64__
+	// AVX2 is used only for wide cubes; for short ones, it is slower than popcount
+	if ( nWordsIn >= (int)(32/sizeof(word)) && 
+		 __builtin_cpu_supports( "popcnt" ) && __builtin_cpu_supports( "avx2" ) )
+		s_pCountDiffVars = CountDiffVarsAvx2;
+#endif
+#endif
+	if ( g_CoverInfo.Verbosity > 1 )
+	{
+		printf( "Cube distance kernel: " );
+		if ( s_pCountDiffVars == CountDiffVarsTable )
+			printf( "table\n" );
+#ifdef USE_X86_KERNELS
+		else if ( s_pCountDiffVars == CountDiffVarsPopcnt )
+			printf( "popcount\n" );
+#ifdef __x86_64__
+		else if ( s_pCountDiffVars == CountDiffVarsAvx2 )
+			printf( "AVX2 + popcount\n" );
+#endif
+#endif
+	}
+}
+
 ////////////////////////////////////////////////////////////////////////
 ///                   INLINE FUNCTION DEFINITIONS                    ///
 ////////////////////////////////////////////////////////////////////////
@@ -185,14 +266,18 @@ void ExorVar( Cube * pC, int Var, varvalue Val )
 // ((cube[VAR_WORD((v)<<1)]) ^ ( (pol)<<VAR_BIT((v)<<1) ))
 {
 	int Bit = (Var<<1);
-	pC->pCubeDataIn[VarWord(Bit)] ^= ( Val << VarBit(Bit) );
+	pC->pCubeDataIn[VarWord(Bit)] ^= ( (word)Val << VarBit(Bit) );
 }
 
 ////////////////////////////////////////////////////////////////////////
 ///                      FUNCTION DEFINITIONS                        ///
 ////////////////////////////////////////////////////////////////////////
 
-static int DiffVarCounter, cVars;
+// (only GetDistance() and GetDistancePlus() use these variables; 
+// FindDiffVars(), ScanCloseCubes() and the kernels behind them work 
+// with locals, because they are also called by the threads evaluating 
+// cube pairs, see PairBatchThread() in "exorList.c")
+static int DiffVarCounter;
 static word Temp1, Temp2, Temp;
 static word LastNonZeroWord;
 static int LastNonZeroWordNum;
@@ -200,22 +285,21 @@ static int LastNonZeroWordNum;
 int GetDistance( Cube * pC1, Cube * pC2 )
 // finds and returns the distance between two cubes pC1 and pC2
 {
-	int i;
-	DiffVarCounter = 0;
+	return GetDistanceBits( pC1->pCubeDataIn, pC1->pCubeDataOut, pC2->pCubeDataIn, pC2->pCubeDataOut );
+}
 
-	for ( i = 0; i < g_CoverInfo.nWordsIn; i++ )
-	{
-		Temp1 = pC1->pCubeDataIn[i] ^ pC2->pCubeDataIn[i];
-		Temp2 = (Temp1|(Temp1>>1)) & DIFFERENT;
+int GetDistanceBits( word * pIn1, word * pOut1, word * pIn2, word * pOut2 )
+// finds and returns the distance between two cubes given by their input and output parts
+{
+	int i;
 
-		// count how many bits are one in this var difference
-		DiffVarCounter  += BIT_COUNT(Temp2);
-		if ( DiffVarCounter > 4 )
-			return 5;
-	}
+	// count the different variables in the input parts
+	DiffVarCounter = s_pCountDiffVars( pIn1, pIn2, g_CoverInfo.nWordsIn );
+	if ( DiffVarCounter > 4 )
+		return 5;
 	// check whether the output parts are different
 	for ( i = 0; i < g_CoverInfo.nWordsOut; i++ )
-		if ( pC1->pCubeDataOut[i] ^ pC2->pCubeDataOut[i] )
+		if ( pOut1[i] ^ pOut2[i] )
 		{
 			DiffVarCounter++;
 			break;
@@ -229,32 +313,25 @@ extern int s_DiffVarValueP_old;
 extern int s_DiffVarValueP_new;
 extern int s_DiffVarValueQ;
 
+int ScanCloseCubes( Cube * p, int Dist, word * pArrIn, word * pArrOut, short * pArrLits, int iStart )
+// looks through the cubes stored in the dense arrays (nWordsIn/nWordsOut words 
+// per cube in pArrIn/pArrOut, the number of literals in pArrLits) at positions 
+// from iStart-1 down to 0; returns the position of the first cube, which is 
+// not farther than Dist from p, or -1 if there is no such cube
+{
+	return s_pScanCloseCubes( p, Dist, pArrIn, pArrOut, pArrLits, iStart );
+}
+
 int GetDistancePlus( Cube * pC1, Cube * pC2 )
 // finds and returns the distance between two cubes pC1 and pC2
 // if the distance is 1, returns the number of diff variable in VarNum
 {
 	int i;
 
-	DiffVarCounter = 0;
-	LastNonZeroWordNum = -1;
-	for ( i = 0; i < g_CoverInfo.nWordsIn; i++ )
-	{
-		Temp1 = pC1->pCubeDataIn[i] ^ pC2->pCubeDataIn[i];
-		Temp2 = (Temp1|(Temp1>>1)) & DIFFERENT;
-
-		// save the value of var difference, in case 
-		// the distance is one and we need to return the var number
-		if ( Temp2 )
-		{
-			LastNonZeroWordNum = i;
-			LastNonZeroWord = Temp2;
-		}
-
-		// count how many bits are one in this var difference
-		DiffVarCounter  += BIT_COUNT(Temp2);
-		if ( DiffVarCounter > 4 )
-			return 5;
-	}
+	// count the different variables in the input parts
+	DiffVarCounter = s_pCountDiffVars( pC1->pCubeDataIn, pC2->pCubeDataIn, g_CoverInfo.nWordsIn );
+	if ( DiffVarCounter > 4 )
+		return 5;
 	// check whether the output parts are different
 	for ( i = 0; i < g_CoverInfo.nWordsOut; i++ )
 		if ( pC1->pCubeDataOut[i] ^ pC2->pCubeDataOut[i] )
@@ -265,6 +342,21 @@ int GetDistancePlus( Cube * pC1, Cube * pC2 )
 
 	if ( DiffVarCounter == 1 )
 	{
+		// find the word with the var difference, 
+		// because the distance is one and we need to return the var number
+		LastNonZeroWordNum = -1;
+		for ( i = 0; i < g_CoverInfo.nWordsIn; i++ )
+		{
+			Temp1 = pC1->pCubeDataIn[i] ^ pC2->pCubeDataIn[i];
+			Temp2 = (Temp1|(Temp1>>1)) & DIFFERENT;
+			if ( Temp2 )
+			{
+				LastNonZeroWordNum = i;
+				LastNonZeroWord = Temp2;
+				break;
+			}
+		}
+
 		if ( LastNonZeroWordNum == -1 ) // the output is the only different variable
 			s_DiffVarNum = -1;
 		else
@@ -293,10 +385,173 @@ int FindDiffVars( int * pDiffVars, Cube * pC1, Cube * pC2 )
 // -1 is written into pDiffVars[0] if the cubes have different outputs
 // returns the number of different variables (including the output)
 {
-	int i, v;
-	DiffVarCounter = 0;
-	// check whether the output parts of the cubes are different
+	return s_pFindDiffVars( pDiffVars, pC1, pC2 );
+}
+
+////////////////////////////////////////////////////////////////////////
+///                     CUBE DISTANCE KERNELS                        ///
+////////////////////////////////////////////////////////////////////////
 
+static int CountDiffVarsTable( word * pIn1, word * pIn2, int nWords )
+// counts the different variables using the bit count table
+{
+	int DiffVarCounter = 0;
+	word Temp1, Temp2;
+	int i;
+
+	for ( i = 0; i < nWords; i++ )
+	{
+		Temp1 = pIn1[i] ^ pIn2[i];
+		Temp2 = (Temp1|(Temp1>>1)) & DIFFERENT;
+
+		// count how many bits are one in this var difference
+		DiffVarCounter  += BIT_COUNT(Temp2);
+		if ( DiffVarCounter > 4 )
+			return 5;
+	}
+	return DiffVarCounter;
+}
+
+static int ScanCloseCubesTable( Cube * p, int Dist, word * pArrIn, word * pArrOut, short * pArrLits, int iStart )
+// scans the dense arrays of cubes using the bit count table
+{
+	int nWordsIn  = g_CoverInfo.nWordsIn;
+	int nWordsOut = g_CoverInfo.nWordsOut;
+	int DiffVarCounter;
+	word Temp1, Temp2;
+	int i, k;
+
+	for ( i = iStart - 1; i >= 0; i-- )
+	{
+		// the number of literals cannot differ by more than the distance
+		if ( (unsigned)(pArrLits[i] - p->a + Dist) > (unsigned)(2 * Dist) )
+			continue;
+		DiffVarCounter = 0;
+		for ( k = 0; k < nWordsIn; k++ )
+		{
+			Temp1 = p->pCubeDataIn[k] ^ pArrIn[i*nWordsIn + k];
+			Temp2 = (Temp1|(Temp1>>1)) & DIFFERENT;
+			DiffVarCounter += BIT_COUNT(Temp2);
+		}
+		if ( DiffVarCounter > Dist )
+			continue;
+		for ( k = 0; k < nWordsOut; k++ )
+			if ( p->pCubeDataOut[k] != pArrOut[i*nWordsOut + k] )
+			{
+				DiffVarCounter++;
+				break;
+			}
+		if ( DiffVarCounter <= Dist )
+			return i;
+	}
+	return -1;
+}
+
+#ifdef USE_X86_KERNELS
+
+__attribute__((target("popcnt")))
+static int ScanCloseCubesPopcnt( Cube * p, int Dist, word * pArrIn, word * pArrOut, short * pArrLits, int iStart )
+// scans the dense arrays of cubes using the hardware popcount
+{
+	int nWordsIn  = g_CoverInfo.nWordsIn;
+	int nWordsOut = g_CoverInfo.nWordsOut;
+	word * pIn = p->pCubeDataIn, * pOut = p->pCubeDataOut;
+	word Diff;
+	int a = p->a;
+	int i, k, Counter;
+
+	for ( i = iStart - 1; i >= 0; i-- )
+	{
+		// the number of literals cannot differ by more than the distance
+		if ( (unsigned)(pArrLits[i] - a + Dist) > (unsigned)(2 * Dist) )
+			continue;
+		Counter = 0;
+		for ( k = 0; k < nWordsIn; k++ )
+		{
+			Diff = pIn[k] ^ pArrIn[i*nWordsIn + k];
+			Counter += __builtin_popcountll( (unsigned long long)((Diff|(Diff>>1)) & DIFFERENT) );
+		}
+		if ( Counter > Dist )
+			continue;
+		for ( k = 0; k < nWordsOut; k++ )
+			if ( pOut[k] != pArrOut[i*nWordsOut + k] )
+			{
+				Counter++;
+				break;
+			}
+		if ( Counter <= Dist )
+			return i;
+	}
+	return -1;
+}
+
+__attribute__((target("popcnt")))
+static int CountDiffVarsPopcnt( word * pIn1, word * pIn2, int nWords )
+// counts the different variables using the hardware popcount on 64-bit chunks
+{
+	unsigned long long Data1, Data2, Diff;
+	int i, Counter = 0;
+
+	for ( i = 0; i + (int)(8/sizeof(word)) <= nWords; i += 8/sizeof(word) )
+	{
+		memcpy( &Data1, pIn1 + i, 8 );
+		memcpy( &Data2, pIn2 + i, 8 );
+		Diff = Data1 ^ Data2;
+		// the bit shifted from the next word lands on the odd position and is masked out
+		Diff = (Diff|(Diff>>1)) & 0x5555555555555555ULL;
+		Counter += __builtin_popcountll( Diff );
+		if ( Counter > 4 )
+			return 5;
+	}
+	for ( ; i < nWords; i++ )
+	{
+		Temp1 = pIn1[i] ^ pIn2[i];
+		Temp2 = (Temp1|(Temp1>>1)) & DIFFERENT;
+		Counter += __builtin_popcountll( (unsigned long long)Temp2 );
+		if ( Counter > 4 )
+			return 5;
+	}
+	return Counter;
+}
+
+#ifdef __x86_64__
+__attribute__((target("avx2,popcnt")))
+static int CountDiffVarsAvx2( word * pIn1, word * pIn2, int nWords )
+// counts the different variables using AVX2 on 256-bit chunks
+// (the cubes with less than 128 variables are handled by the popcount kernel)
+{
+	__m256i Diff, Mask = _mm256_set1_epi32( 0x55555555 );
+	int i, Counter = 0;
+
+	for ( i = 0; i + (int)(32/sizeof(word)) <= nWords; i += 32/sizeof(word) )
+	{
+		Diff = _mm256_xor_si256( _mm256_loadu_si256( (__m256i *)(pIn1 + i) ), 
+		                         _mm256_loadu_si256( (__m256i *)(pIn2 + i) ) );
+		Diff = _mm256_and_si256( _mm256_or_si256( Diff, _mm256_srli_epi64( Diff, 1 ) ), Mask );
+		if ( _mm256_testz_si256( Diff, Diff ) )
+			continue;
+		Counter += __builtin_popcountll( (unsigned long long)_mm256_extract_epi64( Diff, 0 ) );
+		Counter += __builtin_popcountll( (unsigned long long)_mm256_extract_epi64( Diff, 1 ) );
+		Counter += __builtin_popcountll( (unsigned long long)_mm256_extract_epi64( Diff, 2 ) );
+		Counter += __builtin_popcountll( (unsigned long long)_mm256_extract_epi64( Diff, 3 ) );
+		if ( Counter > 4 )
+			return 5;
+	}
+	if ( i < nWords )
+		Counter += CountDiffVarsPopcnt( pIn1 + i, pIn2 + i, nWords - i );
+	return ( Counter > 4 )? 5: Counter;
+}
+#endif
+
+__attribute__((target("popcnt")))
+static int FindDiffVarsPopcnt( int * pDiffVars, Cube * pC1, Cube * pC2 )
+// finds the different variables using the hardware popcount
+// (the variables are found in the same order as by FindDiffVarsTable())
+{
+	int DiffVarCounter = 0;
+	word Temp1, Temp2;
+	int i;
+	// check whether the output parts of the cubes are different
 	for ( i = 0; i < g_CoverInfo.nWordsOut; i++ )
 		if ( pC1->pCubeDataOut[i] != pC2->pCubeDataOut[i] )
 		{ // they are different
@@ -307,43 +562,62 @@ int FindDiffVars( int * pDiffVars, Cube * pC1, Cube * pC2 )
 
 	for ( i = 0; i < g_CoverInfo.nWordsIn; i++ )
 	{
-
 		Temp1 = pC1->pCubeDataIn[i] ^ pC2->pCubeDataIn[i];
 		Temp2 = (Temp1|(Temp1>>1)) & DIFFERENT;
+		if ( Temp2 == 0 )
+			continue;
+		if ( DiffVarCounter + __builtin_popcountll( (unsigned long long)Temp2 ) > 4 )
+			return 5;
+		// write the variables in the increasing order
+		for ( ; Temp2; Temp2 &= Temp2 - 1 )
+			pDiffVars[ DiffVarCounter++ ] = i*BPI/2 + __builtin_ctzll( (unsigned long long)Temp2 )/2;
+	}
+	return DiffVarCounter;
+}
 
-		// check the first part of this word
-		Temp = Temp2 & 0xffff;
-		cVars = BitCount[ Temp ];
-		if ( cVars )
-		{
-			if ( cVars < 5 )
-				for ( v = 0; v < cVars; v++ )
-				{
-					assert( BitGroupNumbers[Temp] != MARKNUMBER );
-					pDiffVars[ DiffVarCounter++ ] = i*16 + GroupLiterals[ BitGroupNumbers[Temp] ][v];
-				}
-			else
-				return 5;
+#endif
+
+static int FindDiffVarsTable( int * pDiffVars, Cube * pC1, Cube * pC2 )
+// finds the different variables using the bit group tables
+{
+	int DiffVarCounter = 0, cVars;
+	word Temp1, Temp2, Temp;
+	int i, v, s;
+	// check whether the output parts of the cubes are different
+
+	for ( i = 0; i < g_CoverInfo.nWordsOut; i++ )
+		if ( pC1->pCubeDataOut[i] != pC2->pCubeDataOut[i] )
+		{ // they are different
+			pDiffVars[0] = -1;
+			DiffVarCounter = 1;
+			break;
 		}
-		if ( DiffVarCounter > 4 )
-			return 5;
 
-		// check the second part of this word
-		Temp = Temp2 >> 16;
-		cVars = BitCount[ Temp ];
-		if ( cVars )
+	for ( i = 0; i < g_CoverInfo.nWordsIn; i++ )
+	{
+
+		Temp1 = pC1->pCubeDataIn[i] ^ pC2->pCubeDataIn[i];
+		Temp2 = (Temp1|(Temp1>>1)) & DIFFERENT;
+
+		// check the 16-bit parts of this word (8 variables each)
+		for ( s = 0; s < BPI; s += 16 )
 		{
-			if ( cVars < 5 )
-				for ( v = 0; v < cVars; v++ )
-				{
-					assert( BitGroupNumbers[Temp] != MARKNUMBER );
-					pDiffVars[ DiffVarCounter++ ] = i*16 + 8 + GroupLiterals[ BitGroupNumbers[Temp] ][v];
-				}
-			else
+			Temp = (Temp2 >> s) & 0xffff;
+			cVars = BitCount[ Temp ];
+			if ( cVars )
+			{
+				if ( DiffVarCounter + cVars < 5 )
+					for ( v = 0; v < cVars; v++ )
+					{
+						assert( BitGroupNumbers[Temp] != MARKNUMBER );
+						pDiffVars[ DiffVarCounter++ ] = i*BPI/2 + s/2 + GroupLiterals[ BitGroupNumbers[Temp] ][v];
+					}
+				else
+					return 5;
+			}
+			if ( DiffVarCounter > 4 )
 				return 5;
 		}
-		if ( DiffVarCounter > 4 )
-			return 5;
 	}
 	return DiffVarCounter;
 }
@@ -367,7 +641,7 @@ void InsertVars( Cube * pC, int * pVars, int nVarsIn, int * pVarValues )
 		LocalBit  = VarBit(GlobalBit);
 
 		// correct this variables
-		pC->pCubeDataIn[LocalWord] = ((pC->pCubeDataIn[LocalWord]&(~(3<<LocalBit)))|(pVarValues[i]<<LocalBit));
+		pC->pCubeDataIn[LocalWord] = ((pC->pCubeDataIn[LocalWord]&(~((word)3<<LocalBit)))|((word)pVarValues[i]<<LocalBit));
 	}
 }
 
@@ -390,10 +664,10 @@ void InsertVarsWithoutClearing( Cube * pC, int * pVars, int nVarsIn, int * pVarV
 		LocalBit  = VarBit(GlobalBit);
 
 		// correct this variables
-		pC->pCubeDataIn[LocalWord] |= ( pVarValues[i] << LocalBit );
+		pC->pCubeDataIn[LocalWord] |= ( (word)pVarValues[i] << LocalBit );
 	}
 	// insert the output bit
-	pC->pCubeDataOut[VarWord(Output)] |= ( 1 << VarBit(Output) );
+	pC->pCubeDataOut[VarWord(Output)] |= ( (word)1 << VarBit(Output) );
 }
 
 ///////////////////////////////////////////////////////////////////
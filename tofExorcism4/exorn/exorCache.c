@@ -0,0 +1,324 @@
+////////////////////////////////////////////////////////////////////////
+///                                                                  ///
+///                  Implementation of EXORCISM - 4                  ///
+///              An Exclusive Sum-of-Product Minimizer               ///
+///               Alan Mishchenko  <alanmi@ee.pdx.edu>               ///
+///                                                                  ///
+////////////////////////////////////////////////////////////////////////
+///                                                                  ///
+///                          Cache Module                            ///
+///                                                                  ///
+///      1) the canonical hash of the multi-output function          ///
+///      2) reading/writing the minimized covers in the cache        ///
+///                                                                  ///
+////////////////////////////////////////////////////////////////////////
+///   This software was tested with the BDD package "CUDD", v.2.3.0  ///
+///                          by Fabio Somenzi                        ///
+///                  http://vlsi.colorado.edu/~fabio/                ///
+////////////////////////////////////////////////////////////////////////
+
+#include "exor.h"
+#include "extra.h"
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+////////////////////////////////////////////////////////////////////////
+///                       EXTERNAL VARIABLES                         ///
+////////////////////////////////////////////////////////////////////////
+
+// information about the options and the cover
+extern cinfo g_CoverInfo;
+
+// the cover access procedures
+extern Cube* IterCubeSetStart();
+extern Cube* IterCubeSetNext();
+extern varvalue GetVar( Cube* pC, int Var );
+
+// the records of the cubes read from the cache
+extern int   CubeRecordSize();
+extern char* CubeRecordWrite( char* pRecord, int nLits, int nOuts, word* pIn, word* pOut );
+
+////////////////////////////////////////////////////////////////////////
+///                    FUNCTIONS OF THIS MODULE                      ///
+////////////////////////////////////////////////////////////////////////
+
+// derives the cache key of the function and the minimization options
+int   CacheComputeKey( DdManager * dd, DdNode ** pOutputs, int nInputs, int nOutputs, char * pKey );
+// reads the cover from the cache; returns the cube data for PortfolioInstallCover()
+char* CacheRead( char * pDir, char * pKey, int * pnCubes, int * pnLits );
+// writes the current cover into the cache
+int   CacheWrite( char * pDir, char * pKey );
+
+// the hash of the function
+static unsigned long long CacheEval( DdNode * bFunc, st_table * tVisited, unsigned long long * pValues, int * pnValues );
+static unsigned long long CacheRandom( unsigned long long Seed );
+static unsigned long long CacheMulMod( unsigned long long a, unsigned long long b );
+
+////////////////////////////////////////////////////////////////////////
+///                        STATIC VARIABLES                          ///
+////////////////////////////////////////////////////////////////////////
+
+// the hash is computed modulo the prime 2^61 - 1
+#define CACHE_PRIME  ((((unsigned long long)1) << 61) - 1)
+
+// the seeds of the random points of the variables and the outputs
+#define CACHE_SEED_VAR   0x5eed0001
+#define CACHE_SEED_OUT   0x5eed0002
+
+////////////////////////////////////////////////////////////////////////
+///                      FUNCTION DEFINITIONS                        ///
+////////////////////////////////////////////////////////////////////////
+
+int CacheComputeKey( DdManager * dd, DdNode ** pOutputs, int nInputs, int nOutputs, char * pKey )
+// the hash of each output is the value of its multi-linear polynomial at the
+// random point (each variable gets a pseudo-random number depending on its index);
+// it does not depend on the order of the variables in the bdd or on how the
+// function was written in the file, and two different functions get the same
+// value with the probability at most nInputs/(2^61 - 1); the output hashes are
+// combined with the pseudo-random weights of the outputs; the key also includes
+// the numbers of inputs and outputs and the options affecting the minimized cover
+// (-q, -m, -p, -N, -S and -k; the budget of the queques matters when
+// the cube pairs are dropped)
+// returns 0 if memory cannot be allocated
+{
+	st_table * tVisited;
+	unsigned long long * pValues, Hash = 0;
+	int nValues = 0, o;
+
+	pValues = ALLOC( unsigned long long, Cudd_SharingSize( pOutputs, nOutputs ) + 1 );
+	tVisited = st_init_table( st_ptrcmp, st_ptrhash );
+	if ( pValues == NULL || tVisited == NULL )
+	{
+		FREE( pValues );
+		if ( tVisited )
+			st_free_table( tVisited );
+		return 0;
+	}
+	for ( o = 0; o < nOutputs; o++ )
+	{
+		Hash += CacheMulMod( CacheRandom( CACHE_SEED_OUT + o ) , CacheEval( pOutputs[o], tVisited, pValues, &nValues ) );
+		Hash %= CACHE_PRIME;
+	}
+	st_free_table( tVisited );
+	FREE( pValues );
+
+	sprintf( pKey, "%016llx-i%d-o%d-q%d-m%d-p%d%s", Hash, nInputs, nOutputs, g_CoverInfo.Quality, g_CoverInfo.QueBudget,
+		g_CoverInfo.nPortfolio, g_CoverInfo.fClasses? "-N" : "" );
+	if ( g_CoverInfo.CoverGen )
+		sprintf( pKey + strlen(pKey), "-S%d", g_CoverInfo.CoverGen );
+	// the clusters of outputs are minimized separately, while the number
+	// of the clusters minimized at a time does not change their covers
+	if ( g_CoverInfo.nClusterJobs > 0 )
+		sprintf( pKey + strlen(pKey), "-k" );
+	return 1;
+}
+
+static unsigned long long CacheEval( DdNode * bFunc, st_table * tVisited, unsigned long long * pValues, int * pnValues )
+// returns the value of the function at the random point: (1 - r) * f0 + r * f1
+// for the node with the variable having the random number r; the values of
+// the regular nodes are stored in pValues, the table maps the node into the entry
+{
+	DdNode * bReg = Cudd_Regular( bFunc );
+	unsigned long long Value, V0, V1;
+	char * pEntry;
+
+	if ( cuddIsConstant(bReg) )
+		Value = 1;
+	else if ( st_lookup( tVisited, (char*)bReg, &pEntry ) )
+		Value = pValues[(size_t)pEntry];
+	else
+	{
+		V0 = CacheEval( cuddE(bReg), tVisited, pValues, pnValues );
+		V1 = CacheEval( cuddT(bReg), tVisited, pValues, pnValues );
+		Value = (V0 + CacheMulMod( CacheRandom( CACHE_SEED_VAR + bReg->index ), (V1 + CACHE_PRIME - V0) % CACHE_PRIME )) % CACHE_PRIME;
+		pValues[*pnValues] = Value;
+		st_insert( tVisited, (char*)bReg, (char*)(size_t)(*pnValues)++ );
+	}
+	// the complemented function has the value 1 - Value
+	if ( Cudd_IsComplement(bFunc) )
+		Value = (1 + CACHE_PRIME - Value) % CACHE_PRIME;
+	return Value;
+}
+
+static unsigned long long CacheRandom( unsigned long long Seed )
+// returns the pseudo-random number below 2^61 - 1 for the given seed
+// (the same numbers on all platforms)
+{
+	Seed += 0x9e3779b97f4a7c15ULL;
+	Seed = (Seed ^ (Seed >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	Seed = (Seed ^ (Seed >> 27)) * 0x94d049bb133111ebULL;
+	Seed = Seed ^ (Seed >> 31);
+	return Seed % CACHE_PRIME;
+}
+
+static unsigned long long CacheMulMod( unsigned long long a, unsigned long long b )
+// returns a * b modulo 2^61 - 1 for a, b < 2^61 - 1 using the 31-bit halves
+// of the numbers (2^61 is 1 and 2^62 is 2 modulo the prime)
+{
+	unsigned long long aHi = a >> 31, aLo = a & 0x7fffffff;
+	unsigned long long bHi = b >> 31, bLo = b & 0x7fffffff;
+	unsigned long long Mid = aHi * bLo + aLo * bHi;
+	unsigned long long Sum;
+	Sum  = 2 * aHi * bHi;
+	Sum += (Mid >> 30) + ((Mid & 0x3fffffff) << 31);
+	Sum += aLo * bLo;
+	Sum  = (Sum & CACHE_PRIME) + (Sum >> 61);
+	Sum  = (Sum & CACHE_PRIME) + (Sum >> 61);
+	return (Sum >= CACHE_PRIME)? Sum - CACHE_PRIME : Sum;
+}
+
+char* CacheRead( char * pDir, char * pKey, int * pnCubes, int * pnLits )
+// reads the cover of the cache entry into the records of the cubes 
+// (see CubeRecordWrite() in "exorCubes.c"), as received by PortfolioReceiveCover();
+// the cubes are stored in the reverse order, because PortfolioInstallCover()
+// inserts each cube at the beginning of the list, so that the installed cover
+// is traversed in the same order as the cover that was written;
+// the cube lines are parsed in place, so a malformed line is never copied;
+// returns NULL if the entry does not exist or does not match the function
+{
+	int nWords = g_CoverInfo.nWordsIn + g_CoverInfo.nWordsOut;
+	int nCubeBytes = CubeRecordSize();
+	char FileName[1024], Line[1024], * pIn, * pOut, * pBuffer = NULL;
+	word * pData;
+	int Counts[2], nIns = -1, nOuts = -1, nCubes = -1, c = 0, v;
+	FILE * pFile;
+
+	sprintf( FileName, "%s/%s.esop", pDir, pKey );
+	pFile = fopen( FileName, "r" );
+	if ( pFile == NULL )
+		return NULL;
+	pData = ALLOC( word, nWords );
+	if ( pData == NULL )
+	{
+		printf( "\nUnexpected memory allocation problem. Quitting...\n" );
+		fclose( pFile );
+		return NULL;
+	}
+	*pnLits = 0;
+	while ( fgets( Line, 1024, pFile ) )
+	{
+		if ( Line[0] == '#' || Line[0] == '\n' )
+			continue;
+		if ( Line[0] == '.' )
+		{
+			if ( !strncmp( Line, ".i ", 3 ) )
+				nIns = atoi( Line + 3 );
+			else if ( !strncmp( Line, ".o ", 3 ) )
+				nOuts = atoi( Line + 3 );
+			else if ( !strncmp( Line, ".p ", 3 ) )
+				nCubes = atoi( Line + 3 );
+			else if ( !strncmp( Line, ".e", 2 ) )
+				break;
+			// allocate the cubes when the header is read
+			if ( pBuffer == NULL && nIns >= 0 && nOuts >= 0 && nCubes >= 0 )
+			{
+				if ( nIns != g_CoverInfo.nVarsIn || nOuts != g_CoverInfo.nVarsOut || nCubes > (1<<30) / nCubeBytes )
+					goto failed;
+				pBuffer = (char*) malloc( nCubes * nCubeBytes + 1 );
+				if ( pBuffer == NULL )
+					goto failed;
+			}
+			continue;
+		}
+		// the cube line is longer than the buffer
+		if ( pBuffer == NULL || c == nCubes || strchr( Line, '\n' ) == NULL )
+			goto failed;
+		// the line should contain two tokens of nIns and nOuts characters
+		pIn  = Line + strspn( Line, " \t" );
+		if ( (int)strcspn( pIn, " \t\r\n" ) != nIns )
+			goto failed;
+		pOut = pIn + nIns + strspn( pIn + nIns, " \t" );
+		if ( pOut == pIn + nIns || (int)strcspn( pOut, " \t\r\n" ) != nOuts )
+			goto failed;
+		if ( pOut[nOuts + strspn( pOut + nOuts, " \t\r" )] != '\n' )
+			goto failed;
+		// derive the cube
+		memset( pData, 0, sizeof(word) * nWords );
+		Counts[0] = Counts[1] = 0;
+		for ( v = 0; v < nIns; v++ )
+		{
+			if ( pIn[v] == '0' )
+				pData[VarWord(v<<1)] |= ((word)VAR_NEG) << VarBit(v<<1);
+			else if ( pIn[v] == '1' )
+				pData[VarWord(v<<1)] |= ((word)VAR_POS) << VarBit(v<<1);
+			else if ( pIn[v] == '-' )
+				pData[VarWord(v<<1)] |= ((word)VAR_ABS) << VarBit(v<<1);
+			else
+				goto failed;
+			Counts[0] += ( pIn[v] != '-' );
+		}
+		for ( v = 0; v < nOuts; v++ )
+			if ( pOut[v] == '1' )
+			{
+				pData[g_CoverInfo.nWordsIn + v/BPI] |= ((word)1) << (v%BPI);
+				Counts[1]++;
+			}
+			else if ( pOut[v] != '0' )
+				goto failed;
+		CubeRecordWrite( pBuffer + (nCubes - 1 - c) * nCubeBytes, Counts[0], Counts[1], pData, pData + g_CoverInfo.nWordsIn );
+		*pnLits += Counts[0];
+		c++;
+	}
+	if ( pBuffer == NULL || c != nCubes )
+		goto failed;
+	fclose( pFile );
+	FREE( pData );
+	*pnCubes = nCubes;
+	return pBuffer;
+
+failed:
+	fclose( pFile );
+	FREE( pData );
+	if ( pBuffer )
+		free( pBuffer );
+	return NULL;
+}
+
+int CacheWrite( char * pDir, char * pKey )
+// writes the cover into the temporary file and renames it into the entry,
+// so that the processes reading the cache at the same time never see
+// a partially written entry; returns 1 on success
+{
+	char FileName[1024], FileTemp[1100];
+	FILE * pFile;
+	Cube * p;
+	int v;
+
+	// the directory may exist already
+	mkdir( pDir, 0777 );
+	sprintf( FileName, "%s/%s.esop", pDir, pKey );
+	sprintf( FileTemp, "%s.tmp%d", FileName, (int)getpid() );
+	pFile = fopen( FileTemp, "w" );
+	if ( pFile == NULL )
+		return 0;
+	fprintf( pFile, "# EXORCISM-4 cache entry %s\n", pKey );
+	fprintf( pFile, ".i %d\n", g_CoverInfo.nVarsIn );
+	fprintf( pFile, ".o %d\n", g_CoverInfo.nVarsOut );
+	fprintf( pFile, ".p %d\n", g_CoverInfo.nCubesInUse );
+	fprintf( pFile, ".type esop\n" );
+	for ( p = IterCubeSetStart( ); p; p = IterCubeSetNext() )
+	{
+		for ( v = 0; v < g_CoverInfo.nVarsIn; v++ )
+		{
+			varvalue Value = GetVar( p, v );
+			fputc( (Value == VAR_NEG)? '0' : (Value == VAR_POS)? '1' : '-', pFile );
+		}
+		fputc( ' ', pFile );
+		for ( v = 0; v < g_CoverInfo.nVarsOut; v++ )
+			fputc( (p->pCubeDataOut[v/BPI] & (((word)1) << (v%BPI)))? '1' : '0', pFile );
+		fputc( '\n', pFile );
+	}
+	fprintf( pFile, ".e\n" );
+	if ( fclose( pFile ) != 0 || rename( FileTemp, FileName ) != 0 )
+	{
+		unlink( FileTemp );
+		return 0;
+	}
+	return 1;
+}
+
+///////////////////////////////////////////////////////////////////
+////////////              End of File             /////////////////
+///////////////////////////////////////////////////////////////////
@@ -0,0 +1,455 @@
+////////////////////////////////////////////////////////////////////////
+///                                                                  ///
+///                  Implementation of EXORCISM - 4                  ///
+///              An Exclusive Sum-of-Product Minimizer               ///
+///               Alan Mishchenko  <alanmi@ee.pdx.edu>               ///
+///                                                                  ///
+////////////////////////////////////////////////////////////////////////
+///                                                                  ///
+///                     Toffoli Cascade Module                       ///
+///                                                                  ///
+///      1) the in-memory Toffoli cascade (gates with control masks) ///
+///      2) writing the cascade as TFC text or as binary gate list   ///
+///      3) the quantum cost and the peephole optimization           ///
+///                                                                  ///
+////////////////////////////////////////////////////////////////////////
+///   This software was tested with the BDD package "CUDD", v.2.3.0  ///
+///                          by Fabio Somenzi                        ///
+///                  http://vlsi.colorado.edu/~fabio/                ///
+////////////////////////////////////////////////////////////////////////
+
+#include "exor.h"
+#include "extra.h"
+#include <string.h>
+
+////////////////////////////////////////////////////////////////////////
+///                       EXTERNAL FUNCTIONS                         ///
+////////////////////////////////////////////////////////////////////////
+
+// adds the gate to the metrics of the cascade
+extern void MetricsAddGate( tmetrics * p, tcascade * pCas, int g );
+
+////////////////////////////////////////////////////////////////////////
+///                    FUNCTIONS OF THIS MODULE                      ///
+////////////////////////////////////////////////////////////////////////
+
+// the cascade allocation/delocation
+tcascade * CascadeAlloc( int nLinesIn, int nOutputs );
+void CascadeFree( tcascade * p );
+// removes the gates and sets the lines of the cascade
+void CascadeRestart( tcascade * p, int nLinesIn, int nOutputs );
+// adds the gate with the given control mask and target line
+int CascadeAddGate( tcascade * p, word * pControls, int nControls, int Target );
+// returns the number of "not" gates (the gates targeting the input lines)
+int CascadeCountNots( tcascade * p );
+
+// returns the quantum cost of one gate and of the cascade
+double CascadeGateCost( int nControls );
+double CascadeQuantumCost( tcascade * p );
+// removes the pairs of equal gates separated by the commuting gates
+int CascadeOptimize( tcascade * p );
+
+// writes the gates as the lines "T<n> x<c>,...,<target>" of the TFC file
+void CascadeWriteTfcGates( tcascade * p, FILE * pFile, tmetrics * pMetrics );
+// writes the cascade as the binary gate list
+void CascadeWriteBinary( tcascade * p, FILE * pFile, tmetrics * pMetrics );
+
+// the peephole optimization
+static int   CascadeOptimizePass( tcascade * p );
+static int   CascadeCompact( tcascade * p );
+static unsigned CascadeGateHash( tcascade * p, int g );
+static int   CascadeGatesEqual( tcascade * p, int g1, int g2 );
+
+// the output buffer
+static void  CascadeFlush();
+static char* CascadeReserve( int nBytes );
+static char* CascadePutInt( char * pBuf, unsigned Num );
+static char* CascadePutWord32( char * pBuf, unsigned Num );
+static char* CascadePutVarint( char * pBuf, unsigned Num );
+static char* CascadePutLine( tcascade * p, char * pBuf, int Line );
+
+////////////////////////////////////////////////////////////////////////
+///                        STATIC VARIABLES                          ///
+////////////////////////////////////////////////////////////////////////
+
+// the output buffer of the writers; the gates are formatted into
+// the buffer, which is written into the file when it is full
+#define CASCADE_BUFFER_SIZE (1<<20)
+static char s_Buffer[CASCADE_BUFFER_SIZE];
+static int s_nBuffer = 0;
+static FILE * s_pFile = NULL;
+
+// the peephole optimization: the hash table of the gates (s_pBins and
+// s_pNext link the gates with the same hash value, the last gate first),
+// the removed gates, and the last gates using each line as the target
+// and as a control
+static int * s_pBins = NULL;
+static int * s_pNext = NULL;
+static char * s_pRemoved = NULL;
+static int * s_pLastTarget = NULL;
+static int * s_pLastControl = NULL;
+static int s_nBins = 0;
+
+////////////////////////////////////////////////////////////////////////
+///                      FUNCTION DEFINITIONS                        ///
+////////////////////////////////////////////////////////////////////////
+
+tcascade * CascadeAlloc( int nLinesIn, int nOutputs )
+// allocates the empty cascade; returns NULL if memory cannot be allocated
+{
+	tcascade * p;
+	p = ALLOC( tcascade, 1 );
+	if ( p == NULL )
+		return NULL;
+	memset( p, 0, sizeof(tcascade) );
+	CascadeRestart( p, nLinesIn, nOutputs );
+	return p;
+}
+
+void CascadeFree( tcascade * p )
+{
+	if ( p == NULL )
+		return;
+	FREE( p->pTargets );
+	FREE( p->pnControls );
+	FREE( p->pControls );
+	FREE( p );
+}
+
+void CascadeRestart( tcascade * p, int nLinesIn, int nOutputs )
+// removes the gates and sets the lines; the memory of the gates is kept
+// if the control masks have the same size
+{
+	int nWords = (nLinesIn + nOutputs + BPI - 1) / BPI;
+	if ( nWords != p->nWords )
+	{
+		FREE( p->pTargets );
+		FREE( p->pnControls );
+		FREE( p->pControls );
+		p->nGatesAlloc = 0;
+	}
+	p->nLinesIn = nLinesIn;
+	p->nOutputs = nOutputs;
+	p->nLines   = nLinesIn + nOutputs;
+	p->nWords   = nWords;
+	p->nGates   = 0;
+}
+
+int CascadeAddGate( tcascade * p, word * pControls, int nControls, int Target )
+// adds the gate at the end of the cascade; pControls is the control mask
+// (nWords words) or NULL for the gate without controls
+// returns 0 if memory cannot be allocated
+{
+	assert( Target >= 0 && Target < p->nLines );
+	if ( p->nGates == p->nGatesAlloc )
+	{
+		p->nGatesAlloc = p->nGatesAlloc ? 2 * p->nGatesAlloc : 1024;
+		p->pTargets   = REALLOC( int, p->pTargets, p->nGatesAlloc );
+		p->pnControls = REALLOC( int, p->pnControls, p->nGatesAlloc );
+		p->pControls  = REALLOC( word, p->pControls, p->nGatesAlloc * p->nWords );
+		if ( p->pTargets == NULL || p->pnControls == NULL || p->pControls == NULL )
+			return 0;
+	}
+	p->pTargets[p->nGates]   = Target;
+	p->pnControls[p->nGates] = nControls;
+	if ( pControls )
+		memcpy( CascadeControls(p, p->nGates), pControls, sizeof(word) * p->nWords );
+	else
+		memset( CascadeControls(p, p->nGates), 0, sizeof(word) * p->nWords );
+	p->nGates++;
+	return 1;
+}
+
+int CascadeCountNots( tcascade * p )
+{
+	int g, Counter = 0;
+	for ( g = 0; g < p->nGates; g++ )
+		Counter += ( p->pTargets[g] < p->nLinesIn );
+	return Counter;
+}
+
+double CascadeGateCost( int nControls )
+// the NCV quantum cost: 1 for the gates with at most one control
+// and 2^n - 3 for the gates with n >= 3 lines (5 for the Toffoli gate)
+{
+	double Pow = 1.0;
+	int n;
+	if ( nControls < 2 )
+		return 1.0;
+	for ( n = 0; n <= nControls; n++ )
+		Pow *= 2.0;
+	return Pow - 3.0;
+}
+
+double CascadeQuantumCost( tcascade * p )
+{
+	double Cost = 0.0;
+	int g;
+	for ( g = 0; g < p->nGates; g++ )
+		Cost += CascadeGateCost( p->pnControls[g] );
+	return Cost;
+}
+
+int CascadeOptimize( tcascade * p )
+// two equal gates cancel if the gates between them commute with them;
+// the gates (C, t) and (D, s) commute if t is not in D and s is not in C;
+// the gates are looked up in the hash table by their controls and target,
+// and the last gates using each line tell whether the gate commutes with
+// all gates after the found one, so that one pass takes linear time;
+// the passes are repeated while the gates are removed, because the gates
+// removed in the pass still block the later pairs
+// returns the number of removed gates or -1 if memory cannot be allocated
+{
+	int nRemoved, nRemovedAll = 0;
+	for ( s_nBins = 1; s_nBins < 2 * p->nGates; s_nBins <<= 1 );
+	s_pBins        = ALLOC( int, s_nBins );
+	s_pNext        = ALLOC( int, p->nGates + 1 );
+	s_pRemoved     = ALLOC( char, p->nGates + 1 );
+	s_pLastTarget  = ALLOC( int, p->nLines );
+	s_pLastControl = ALLOC( int, p->nLines );
+	if ( s_pBins == NULL || s_pNext == NULL || s_pRemoved == NULL ||
+		 s_pLastTarget == NULL || s_pLastControl == NULL )
+		nRemovedAll = -1;
+	else
+	{
+		do {
+			nRemoved = CascadeOptimizePass( p );
+			nRemovedAll += nRemoved;
+		} while ( nRemoved > 0 );
+	}
+	FREE( s_pBins );
+	FREE( s_pNext );
+	FREE( s_pRemoved );
+	FREE( s_pLastTarget );
+	FREE( s_pLastControl );
+	return nRemovedAll;
+}
+
+static int CascadeOptimizePass( tcascade * p )
+// performs one pass over the gates and removes the gates that cancel
+{
+	word * pControls, Word;
+	unsigned Hash;
+	int g, f, w, Line, fCommute;
+
+	memset( s_pBins, 0xff, sizeof(int) * s_nBins );
+	memset( s_pRemoved, 0, sizeof(char) * p->nGates );
+	memset( s_pLastTarget, 0xff, sizeof(int) * p->nLines );
+	memset( s_pLastControl, 0xff, sizeof(int) * p->nLines );
+	for ( g = 0; g < p->nGates; g++ )
+	{
+		// find the last gate equal to this one that is not removed
+		Hash = CascadeGateHash( p, g ) & (s_nBins - 1);
+		for ( f = s_pBins[Hash]; f >= 0; f = s_pNext[f] )
+			if ( !s_pRemoved[f] && CascadeGatesEqual( p, f, g ) )
+				break;
+		// check that the gates after it commute with this gate
+		fCommute = ( f >= 0 && s_pLastControl[p->pTargets[g]] < f );
+		pControls = CascadeControls( p, g );
+		for ( w = 0; fCommute && w < p->nWords; w++ )
+			for ( Word = pControls[w], Line = w * BPI; Word; Word >>= 1, Line++ )
+				if ( (Word & 1) && s_pLastTarget[Line] > f )
+				{
+					fCommute = 0;
+					break;
+				}
+		if ( fCommute )
+		{
+			s_pRemoved[f] = s_pRemoved[g] = 1;
+			continue;
+		}
+		// add the gate
+		s_pNext[g] = s_pBins[Hash];
+		s_pBins[Hash] = g;
+		s_pLastTarget[p->pTargets[g]] = g;
+		for ( w = 0; w < p->nWords; w++ )
+			for ( Word = pControls[w], Line = w * BPI; Word; Word >>= 1, Line++ )
+				if ( Word & 1 )
+					s_pLastControl[Line] = g;
+	}
+	return CascadeCompact( p );
+}
+
+static int CascadeCompact( tcascade * p )
+// removes the marked gates; returns the number of removed gates
+{
+	int g, k;
+	for ( g = k = 0; g < p->nGates; g++ )
+	{
+		if ( s_pRemoved[g] )
+			continue;
+		if ( k < g )
+		{
+			p->pTargets[k]   = p->pTargets[g];
+			p->pnControls[k] = p->pnControls[g];
+			memcpy( CascadeControls(p, k), CascadeControls(p, g), sizeof(word) * p->nWords );
+		}
+		k++;
+	}
+	g = p->nGates - k;
+	p->nGates = k;
+	return g;
+}
+
+static unsigned CascadeGateHash( tcascade * p, int g )
+{
+	word * pControls = CascadeControls( p, g );
+	unsigned Hash = (unsigned)p->pTargets[g] * 2654435761u;
+	int w;
+	for ( w = 0; w < p->nWords; w++ )
+	{
+		Hash ^= (unsigned)pControls[w] + (unsigned)w * 40503u;
+#if BPI == 64
+		Hash ^= (unsigned)(pControls[w] >> 32);
+#endif
+		Hash *= 2654435761u;
+	}
+	return Hash ^ (Hash >> 16);
+}
+
+static int CascadeGatesEqual( tcascade * p, int g1, int g2 )
+{
+	return p->pTargets[g1] == p->pTargets[g2] && p->pnControls[g1] == p->pnControls[g2] &&
+		!memcmp( CascadeControls(p, g1), CascadeControls(p, g2), sizeof(word) * p->nWords );
+}
+
+void CascadeWriteTfcGates( tcascade * p, FILE * pFile, tmetrics * pMetrics )
+// writes one line for each gate; the control lines follow in the order of the lines;
+// the metrics of the written gates are collected into pMetrics (if given)
+{
+	word * pControls, Word;
+	char * pBuf;
+	int g, w, Line;
+
+	s_pFile = pFile;
+	s_nBuffer = 0;
+	for ( g = 0; g < p->nGates; g++ )
+	{
+		if ( pMetrics )
+			MetricsAddGate( pMetrics, p, g );
+		// each line name takes at most 12 characters
+		pBuf = CascadeReserve( 12 * (p->pnControls[g] + 2) );
+		*pBuf++ = 'T';
+		pBuf = CascadePutInt( pBuf, p->pnControls[g] + 1 );
+		*pBuf++ = ' ';
+		pControls = CascadeControls( p, g );
+		for ( w = 0; w < p->nWords; w++ )
+			for ( Word = pControls[w], Line = w * BPI; Word; Word >>= 1, Line++ )
+				if ( Word & 1 )
+				{
+					pBuf = CascadePutLine( p, pBuf, Line );
+					*pBuf++ = ',';
+				}
+		pBuf = CascadePutLine( p, pBuf, p->pTargets[g] );
+		*pBuf++ = '\n';
+		s_nBuffer = pBuf - s_Buffer;
+	}
+	CascadeFlush();
+}
+
+void CascadeWriteBinary( tcascade * p, FILE * pFile, tmetrics * pMetrics )
+// the binary gate list: the 4 bytes "TFCB", the version, the number of
+// the input lines, the number of the outputs, and the number of the gates
+// (the 32-bit numbers with the least significant byte first), followed
+// by the gates; each gate is the number of the control lines, the target
+// line, and the control lines (written by CascadePutVarint()); the outputs
+// follow the input lines; the "not" gate has no control lines;
+// the metrics of the written gates are collected into pMetrics (if given)
+{
+	word * pControls, Word;
+	char * pBuf;
+	int g, w, Line;
+
+	s_pFile = pFile;
+	s_nBuffer = 0;
+	pBuf = CascadeReserve( 20 );
+	memcpy( pBuf, "TFCB", 4 );
+	pBuf = CascadePutWord32( pBuf + 4, 1 );
+	pBuf = CascadePutWord32( pBuf, p->nLinesIn );
+	pBuf = CascadePutWord32( pBuf, p->nOutputs );
+	pBuf = CascadePutWord32( pBuf, p->nGates );
+	s_nBuffer = pBuf - s_Buffer;
+	for ( g = 0; g < p->nGates; g++ )
+	{
+		if ( pMetrics )
+			MetricsAddGate( pMetrics, p, g );
+		pBuf = CascadeReserve( 5 * (p->pnControls[g] + 2) );
+		pBuf = CascadePutVarint( pBuf, p->pnControls[g] );
+		pBuf = CascadePutVarint( pBuf, p->pTargets[g] );
+		pControls = CascadeControls( p, g );
+		for ( w = 0; w < p->nWords; w++ )
+			for ( Word = pControls[w], Line = w * BPI; Word; Word >>= 1, Line++ )
+				if ( Word & 1 )
+					pBuf = CascadePutVarint( pBuf, Line );
+		s_nBuffer = pBuf - s_Buffer;
+	}
+	CascadeFlush();
+}
+
+static void CascadeFlush()
+{
+	fwrite( s_Buffer, 1, s_nBuffer, s_pFile );
+	s_nBuffer = 0;
+}
+
+static char* CascadeReserve( int nBytes )
+// returns the place for nBytes in the buffer
+{
+	if ( s_nBuffer + nBytes > CASCADE_BUFFER_SIZE )
+		CascadeFlush();
+	assert( nBytes <= CASCADE_BUFFER_SIZE );
+	return s_Buffer + s_nBuffer;
+}
+
+static char* CascadePutInt( char * pBuf, unsigned Num )
+// writes the number in decimal
+{
+	char Digits[16];
+	int i = 0;
+	do {
+		Digits[i++] = '0' + Num % 10;
+		Num /= 10;
+	} while ( Num );
+	while ( i )
+		*pBuf++ = Digits[--i];
+	return pBuf;
+}
+
+static char* CascadePutWord32( char * pBuf, unsigned Num )
+// writes the number as 4 bytes, the least significant first
+{
+	pBuf[0] = (char)( Num        & 0xff);
+	pBuf[1] = (char)((Num >>  8) & 0xff);
+	pBuf[2] = (char)((Num >> 16) & 0xff);
+	pBuf[3] = (char)((Num >> 24) & 0xff);
+	return pBuf + 4;
+}
+
+static char* CascadePutVarint( char * pBuf, unsigned Num )
+// writes the number by 7 bits per byte, the least significant first;
+// the highest bit of the byte is set if more bytes follow
+{
+	while ( Num >= 0x80 )
+	{
+		*pBuf++ = (char)((Num & 0x7f) | 0x80);
+		Num >>= 7;
+	}
+	*pBuf++ = (char)Num;
+	return pBuf;
+}
+
+static char* CascadePutLine( tcascade * p, char * pBuf, int Line )
+// writes the name of the line: "x<n>" for the inputs and "f<n>" for the outputs
+{
+	if ( Line < p->nLinesIn )
+	{
+		*pBuf++ = 'x';
+		return CascadePutInt( pBuf, Line );
+	}
+	*pBuf++ = 'f';
+	return CascadePutInt( pBuf, Line - p->nLinesIn );
+}
+
+///////////////////////////////////////////////////////////////////
+////////////              End of File             /////////////////
+///////////////////////////////////////////////////////////////////
@@ -17,6 +17,7 @@
 
 #include "exor.h"
 #include "extra.h"
+#include <string.h>
 
 ////////////////////////////////////////////////////////////////////////
 ///                       EXTERNAL VARIABLES                         ///
@@ -36,6 +37,25 @@ extern int CheckForCloseCubes( Cube* p, int fAddCube );
 ///                    FUNCTIONS OF THIS MODULE                      ///
 ////////////////////////////////////////////////////////////////////////
 
+// computes the starting covers of the outputs; returns the number of cubes
+int  GetNumberOfCubes( DdManager * dd, DdNode ** pbFuncs, int nFuncs );
+// adds the cubes of the starting covers to the cover
+void AddCubesToStartingCover( DdManager * dd );
+// returns the number of the generator with the given name, or -1
+int  CoverGenLookup( char * pName );
+
+// the generators of the starting cover of one output; each returns
+// the referenced ZDD of the ESOP, or NULL if it is not applicable
+typedef DdNode * (*tcovergen)( DdManager * dd, DdNode * bFunc );
+static DdNode * CoverGenIsop( DdManager * dd, DdNode * bFunc );
+static DdNode * CoverGenDisjoint( DdManager * dd, DdNode * bFunc );
+static DdNode * CoverGenFprm( DdManager * dd, DdNode * bFunc );
+
+// the fixed-polarity Reed-Muller form
+static double   CoverFprmCount( DdManager * dd, DdNode * bFunc, DdNode * bSupp, DdNode * bPolar, int nVars );
+static DdNode * CoverFprmSpectrum( DdManager * dd, DdNode * bFunc, DdNode * bSupp, DdNode * bPolar );
+static DdNode * CoverFprmTerms( DdManager * dd, int * pCube, int * pVars, int nVars, int * pPolar );
+
 ////////////////////////////////////////////////////////////////////////
 ///                        STATIC VARIABLES                          ///
 ////////////////////////////////////////////////////////////////////////
@@ -43,20 +63,255 @@ extern int CheckForCloseCubes( Cube* p, int fAddCube );
 // temporary storage for starting ISOP covers
 static DdNode ** s_pzCovers;
 
+// the generators of the starting covers selected by option -S; the pseudo-Kronecker
+// covers (pkrm) are computed for all outputs at once by Extra_zddFastEsopCoverArrayParallel();
+// "best" takes the cover with the smallest number of cubes for each output
+#define COVER_GEN_PKRM   0
+#define COVER_GEN_BEST   4
+static char * s_pCoverGenNames[] = { "pkrm", "isop", "dsop", "fprm", "best", NULL };
+static tcovergen s_pCoverGens[]  = { NULL, CoverGenIsop, CoverGenDisjoint, CoverGenFprm, NULL };
+
+// the fixed-polarity Reed-Muller forms are not computed for the outputs
+// depending on more variables (the number of terms can be exponential)
+#define COVER_FPRM_VARS_MAX   24
+
 ////////////////////////////////////////////////////////////////////////
 ///                      FUNCTION DEFINITIONS                        ///
 ////////////////////////////////////////////////////////////////////////
 
 int GetNumberOfCubes( DdManager * dd, DdNode ** pbFuncs, int nFuncs )
+// computes the starting covers of the outputs by the generator selected
+// by g_CoverInfo.CoverGen; if the generator is not applicable to the output,
+// the pseudo-Kronecker cover is used; returns the total number of cubes
 {
-	int nCubes;
+	int Gen = g_CoverInfo.CoverGen;
+	int pCounts[COVER_GEN_BEST];
+	st_table * tVisited = NULL;
+	DdNode * zCover;
+	int nCubes, o, g, Best;
 	// alloc ZDD variables
 	Cudd_zddVarsFromBddVars( dd, 2 );
 	s_pzCovers = ALLOC( DdNode *, nFuncs );
-	nCubes = Extra_zddFastEsopCoverArray( dd, pbFuncs, s_pzCovers, nFuncs );
+	if ( Gen == COVER_GEN_PKRM || Gen == COVER_GEN_BEST )
+	{
+		nCubes = Extra_zddFastEsopCoverArrayParallel( dd, pbFuncs, s_pzCovers, nFuncs, g_CoverInfo.nThreads );
+		if ( Gen == COVER_GEN_PKRM )
+			return nCubes;
+	}
+
+	// try the other generators
+	memset( pCounts, 0, sizeof(pCounts) );
+	nCubes = 0;
+	for ( o = 0; o < nFuncs; o++ )
+	{
+		Best = COVER_GEN_PKRM;
+		if ( Gen != COVER_GEN_BEST )
+			s_pzCovers[o] = NULL;
+		for ( g = 1; g < COVER_GEN_BEST; g++ )
+		{
+			if ( Gen != COVER_GEN_BEST && Gen != g )
+				continue;
+			zCover = s_pCoverGens[g]( dd, pbFuncs[o] );
+			if ( zCover == NULL )
+				continue;
+			if ( s_pzCovers[o] && Cudd_zddCount( dd, zCover ) >= Cudd_zddCount( dd, s_pzCovers[o] ) )
+			{
+				Cudd_RecursiveDerefZdd( dd, zCover );
+				continue;
+			}
+			if ( s_pzCovers[o] )
+				Cudd_RecursiveDerefZdd( dd, s_pzCovers[o] );
+			s_pzCovers[o] = zCover;
+			Best = g;
+		}
+		if ( s_pzCovers[o] == NULL )
+		{
+			// the table of the numbers of cubes is shared by the outputs,
+			// as in Extra_zddFastEsopCoverArray(), because the covers of
+			// the nodes are also looked up in the computed table
+			if ( tVisited == NULL )
+				tVisited = st_init_table( st_ptrcmp, st_ptrhash );
+			s_pzCovers[o] = Extra_zddFastEsopCover( dd, pbFuncs[o], tVisited, NULL );  Cudd_Ref( s_pzCovers[o] );
+		}
+		nCubes += Cudd_zddCount( dd, s_pzCovers[o] );
+		pCounts[Best]++;
+	}
+	if ( tVisited )
+		st_free_table( tVisited );
+	if ( g_CoverInfo.Verbosity )
+	{
+		printf( "The starting covers of the outputs:" );
+		for ( g = 0; g < COVER_GEN_BEST; g++ )
+			printf( "  %s = %d", s_pCoverGenNames[g], pCounts[g] );
+		printf( "\n" );
+	}
 	return nCubes;
 }
 
+int CoverGenLookup( char * pName )
+{
+	int g;
+	for ( g = 0; s_pCoverGenNames[g]; g++ )
+		if ( strcmp( pName, s_pCoverGenNames[g] ) == 0 )
+			return g;
+	return -1;
+}
+
+static DdNode * CoverGenIsop( DdManager * dd, DdNode * bFunc )
+// returns the irredundant SOP if it is also the ESOP of the function,
+// that is, if the EXOR of its cubes is the function (the cubes are disjoint)
+{
+	DdNode * zCover, * bEsop;
+	zCover = Extra_zddIsopCover( dd, bFunc, bFunc );
+	if ( zCover == NULL )
+		return NULL;
+	Cudd_Ref( zCover );
+	bEsop = Extra_zddConvertEsopToBdd( dd, zCover );  Cudd_Ref( bEsop );
+	if ( bEsop != bFunc )
+	{
+		Cudd_RecursiveDerefZdd( dd, zCover );
+		zCover = NULL;
+	}
+	Cudd_RecursiveDeref( dd, bEsop );
+	return zCover;
+}
+
+static DdNode * CoverGenDisjoint( DdManager * dd, DdNode * bFunc )
+// returns the disjoint SOP given by the paths of the bdd
+{
+	DdNode * zCover;
+	zCover = Extra_zddDisjointCover( dd, bFunc );
+	if ( zCover == NULL )
+		return NULL;
+	Cudd_Ref( zCover );
+	return zCover;
+}
+
+static DdNode * CoverGenFprm( DdManager * dd, DdNode * bFunc )
+// returns the fixed-polarity Reed-Muller form of the function; the polarity
+// is found greedily: starting from the positive polarity, each variable is
+// complemented if this reduces the number of terms
+{
+	DdNode * bSupp, * bPolar, * bTemp, * bSpec, * bCube, * zCover, * zTerms, * zTemp;
+	DdGen * Gen;
+	CUDD_VALUE_TYPE Value;
+	int * pVars, * pPolar, * pCube;
+	int nVars, v;
+	double nTerms, nTermsCur;
+
+	if ( Cudd_IsConstant(bFunc) )
+		return NULL;
+	bSupp = Cudd_Support( dd, bFunc );  Cudd_Ref( bSupp );
+	nVars = Cudd_SupportSize( dd, bFunc );
+	if ( nVars > COVER_FPRM_VARS_MAX )
+	{
+		Cudd_RecursiveDeref( dd, bSupp );
+		return NULL;
+	}
+	pVars  = ALLOC( int, nVars );
+	pPolar = ALLOC( int, Cudd_ReadSize(dd) );
+	if ( pVars == NULL || pPolar == NULL )
+	{
+		printf( "\nUnexpected memory allocation problem. Quitting...\n" );
+		FREE( pVars );
+		FREE( pPolar );
+		Cudd_RecursiveDeref( dd, bSupp );
+		return NULL;
+	}
+	for ( v = 0, bCube = bSupp; bCube != b1; bCube = cuddT(bCube) )
+		pVars[v++] = bCube->index;
+
+	// find the polarity
+	bPolar = b1;  Cudd_Ref( bPolar );
+	nTerms = CoverFprmCount( dd, bFunc, bSupp, bPolar, nVars );
+	for ( v = 0; v < nVars; v++ )
+	{
+		bTemp = Cudd_bddAnd( dd, bPolar, Cudd_bddIthVar( dd, pVars[v] ) );  Cudd_Ref( bTemp );
+		nTermsCur = CoverFprmCount( dd, bFunc, bSupp, bTemp, nVars );
+		if ( nTerms > nTermsCur )
+		{
+			nTerms = nTermsCur;
+			Cudd_RecursiveDeref( dd, bPolar );
+			bPolar = bTemp;
+		}
+		else
+			Cudd_RecursiveDeref( dd, bTemp );
+	}
+	for ( v = 0; v < Cudd_ReadSize(dd); v++ )
+		pPolar[v] = 0;
+	for ( bCube = bPolar; bCube != b1; bCube = cuddT(bCube) )
+		pPolar[bCube->index] = 1;
+
+	// each minterm of the spectrum is the product of the variables equal to 1
+	// (the variables in the negative polarity give the negative literals)
+	bSpec = CoverFprmSpectrum( dd, bFunc, bSupp, bPolar );
+	zCover = z0;  Cudd_Ref( zCover );
+	Cudd_ForeachCube( dd, bSpec, Gen, pCube, Value )
+	{
+		zTerms = CoverFprmTerms( dd, pCube, pVars, nVars, pPolar );
+		zCover = Cudd_zddUnion( dd, zTemp = zCover, zTerms );  Cudd_Ref( zCover );
+		Cudd_RecursiveDerefZdd( dd, zTemp );
+		Cudd_RecursiveDerefZdd( dd, zTerms );
+	}
+	Cudd_RecursiveDeref( dd, bSpec );
+	Cudd_RecursiveDeref( dd, bPolar );
+	Cudd_RecursiveDeref( dd, bSupp );
+	FREE( pVars );
+	FREE( pPolar );
+	return zCover;
+}
+
+static double CoverFprmCount( DdManager * dd, DdNode * bFunc, DdNode * bSupp, DdNode * bPolar, int nVars )
+// returns the number of terms of the Reed-Muller form with the given polarity
+{
+	DdNode * bSpec;
+	double nTerms;
+	bSpec = CoverFprmSpectrum( dd, bFunc, bSupp, bPolar );
+	nTerms = Cudd_CountMinterm( dd, bSpec, nVars );
+	Cudd_RecursiveDeref( dd, bSpec );
+	return nTerms;
+}
+
+static DdNode * CoverFprmSpectrum( DdManager * dd, DdNode * bFunc, DdNode * bSupp, DdNode * bPolar )
+// returns the referenced bdd of the non-zero Reed-Muller coefficients of the function
+// with the variables in bPolar complemented
+{
+	DdNode * bTemp, * aSpec, * bSpec;
+	bTemp = Extra_bddChangePolarity( dd, bFunc, bPolar );  Cudd_Ref( bTemp );
+	aSpec = Extra_bddReedMuller( dd, bTemp, bSupp );        Cudd_Ref( aSpec );
+	bSpec = Cudd_addBddPattern( dd, aSpec );                Cudd_Ref( bSpec );
+	Cudd_RecursiveDeref( dd, bTemp );
+	Cudd_RecursiveDeref( dd, aSpec );
+	return bSpec;
+}
+
+static DdNode * CoverFprmTerms( DdManager * dd, int * pCube, int * pVars, int nVars, int * pPolar )
+// returns the referenced zdd of the terms of the cube of the spectrum:
+// the variable equal to 1 adds its literal to the terms, the variable
+// equal to 0 does not, and the free variable doubles the terms
+{
+	DdNode * zTerms, * zTemp, * zTemp2;
+	int v, Lit;
+	zTerms = z1;  Cudd_Ref( zTerms );
+	for ( v = 0; v < nVars; v++ )
+	{
+		if ( pCube[pVars[v]] == 0 )
+			continue;
+		Lit = 2 * pVars[v] + pPolar[pVars[v]];
+		zTemp2 = Cudd_zddChange( dd, zTerms, Lit );  Cudd_Ref( zTemp2 );
+		if ( pCube[pVars[v]] == 1 )
+		{
+			Cudd_RecursiveDerefZdd( dd, zTerms );
+			zTerms = zTemp2;
+			continue;
+		}
+		zTerms = Cudd_zddUnion( dd, zTemp = zTerms, zTemp2 );  Cudd_Ref( zTerms );
+		Cudd_RecursiveDerefZdd( dd, zTemp );
+		Cudd_RecursiveDerefZdd( dd, zTemp2 );
+	}
+	return zTerms;
+}
+
 void AddCubesToStartingCover( DdManager * dd )
 {
 	int Out;
@@ -119,7 +374,7 @@ void AddCubesToStartingCover( DdManager * dd )
 			// set the ID
 			pNew->ID = g_CoverInfo.cIDs++;
 			// skip through zero-ID
-			if ( g_CoverInfo.cIDs == 256 )
+			if ( g_CoverInfo.cIDs == 0 )
 				g_CoverInfo.cIDs = 1;
 
 		//	cout << "Kro" << endl;
@@ -8,6 +8,7 @@
 ////////////////////////////////////////////////////////////////////////
 ///                                                                  ///
 ///              Cube Allocation and Free Cube Management            ///
+///        (and the records of the cubes sent/saved elsewhere)       ///
 ///                                                                  ///
 ///  Ver. 1.0. Started - July 18, 2000. Last update - July 20, 2000  ///
 ///  Ver. 1.1. Started - July 24, 2000. Last update - July 29, 2000  ///
@@ -21,6 +22,7 @@
 ////////////////////////////////////////////////////////////////////////
 
 #include "exor.h"
+#include <string.h>
 
 ////////////////////////////////////////////////////////////////////////
 ///                       EXTERNAL FUNCTIONS                         ///
@@ -47,6 +49,15 @@ void DelocateCover();
 void AddToFreeCubes( Cube * pC );
 Cube * GetFreeCube();
 
+// allocation of one more piece of cube memory
+static int AllocateCubeChunk( int nCubes );
+
+// the records of the cubes in the buffers of the covers
+// (called from the ExorMain module for the pipes and from the Cache module)
+int    CubeRecordSize();
+char * CubeRecordWrite( char * pRecord, int nLits, int nOuts, word * pIn, word * pOut );
+char * CubeRecordRead( char * pRecord, Cube * p );
+
 ////////////////////////////////////////////////////////////////////////
 ///                      EXPORTED VARIABLES                          ///
 ////////////////////////////////////////////////////////////////////////
@@ -55,8 +66,16 @@ Cube * GetFreeCube();
 ///                      STATIC VARIABLES                            ///
 ////////////////////////////////////////////////////////////////////////
 
-// the pointer to the allocated memory
-Cube ** s_pCoverMemory;
+// the pieces of allocated cube memory
+// (the cover grows on demand by adding new pieces,
+// so that the cubes already in use never move)
+static Cube ** s_pCoverMemory;
+static int s_nChunks;
+static int s_nChunksAlloc;
+
+// the size of one cube with its bit strings and the size of the input part
+static int s_OneCubeSize;
+static int s_OneInputSetSize;
 
 // the list of free cubes
 Cube * s_CubesFree;
@@ -67,65 +86,102 @@ Cube * s_CubesFree;
 
 int AllocateCover( int nCubes, int nWordsIn, int nWordsOut )
 // uses the cover parameters nCubes and nWords
-// to allocate-and-clean the cover in one large piece
+// to allocate-and-clean the first piece of the cover;
+// more pieces are added by GetFreeCube() when the free cubes run out
 {
-	int OneCubeSize;
-	int OneInputSetSize;
-	Cube ** pp;
-	int TotalSize;
-	int i, k;
+	int MemTemp;
 
 	// determine the size of one cube WITH storage for bits
-	OneCubeSize = sizeof(Cube) + (nWordsIn+nWordsOut)*sizeof(unsigned);
+	s_OneCubeSize = sizeof(Cube) + (nWordsIn+nWordsOut)*sizeof(word);
+	// align it, so that the cubes in the piece were aligned 
+	s_OneCubeSize = (s_OneCubeSize + sizeof(void*) - 1) / sizeof(void*) * sizeof(void*);
 	// determine what is the amount of storage for the input part of the cube 
-	OneInputSetSize = nWordsIn*sizeof(unsigned);
+	s_OneInputSetSize = nWordsIn*sizeof(word);
 
-	// allocate memory for the array of pointers
-	pp = (Cube **)malloc( nCubes*sizeof(Cube *) );
-	if ( pp == NULL )
+	// start the array of pieces
+	s_nChunks = 0;
+	s_nChunksAlloc = 16;
+	s_pCoverMemory = (Cube **)malloc( s_nChunksAlloc*sizeof(Cube *) );
+	if ( s_pCoverMemory == NULL )
 		return 0;
 
-	// determine the size of the total cube cover
-	TotalSize = nCubes*OneCubeSize;
-	// allocate and clear memory for the cover in one large piece
-	pp[0] = (Cube *)malloc( TotalSize );
-	if ( pp[0] == NULL )
+	// set the counters of the used and free cubes
+	s_CubesFree = NULL;
+	g_CoverInfo.nCubesAlloc = 0;
+	g_CoverInfo.nCubesInUse = 0;
+	g_CoverInfo.nCubesFree  = 0;
+
+	// allocate the first piece
+	MemTemp = AllocateCubeChunk( nCubes );
+	if ( MemTemp == 0 )
 		return 0;
-	memset( pp[0], 0, TotalSize );
 
-	// assign pointers to cubes and bit strings inside this piece
-	pp[0]->pCubeDataIn  = (unsigned*)(pp[0] + 1);
-	pp[0]->pCubeDataOut = (unsigned*)((char*)pp[0]->pCubeDataIn + OneInputSetSize);
-	for ( i = 1; i < nCubes; i++ )
+	assert ( g_CoverInfo.nCubesInUse + g_CoverInfo.nCubesFree == g_CoverInfo.nCubesAlloc );
+
+	return s_nChunksAlloc*sizeof(Cube *) + MemTemp;
+}
+
+static int AllocateCubeChunk( int nCubes )
+// allocates-and-cleans one piece of memory for nCubes cubes
+// and adds these cubes to the free list;
+// returns the number of bytes allocated, or 0 on failure
+{
+	Cube * pChunk, * p;
+	CubeIdx * pIdx;
+	int TotalSize;
+	int i;
+
+	// make sure there is a place to save the pointer to the piece
+	if ( s_nChunks == s_nChunksAlloc )
 	{
-		pp[i] = (Cube *)((char*)pp[i-1] + OneCubeSize);
-		pp[i]->pCubeDataIn = (unsigned*)(pp[i] + 1);
-		pp[i]->pCubeDataOut = (unsigned*)((char*)pp[i]->pCubeDataIn + OneInputSetSize);
+		Cube ** pTemp = (Cube **)realloc( s_pCoverMemory, 2*s_nChunksAlloc*sizeof(Cube *) );
+		if ( pTemp == NULL )
+			return 0;
+		s_pCoverMemory = pTemp;
+		s_nChunksAlloc *= 2;
 	}
 
-	// connect the cubes into the list using Next pointers
-	for ( k = 0; k < nCubes-1; k++ )
-		pp[k]->Next = pp[k+1];
-	// the last pointer is already set to NULL
-
-	// assign the head of the free list
-	s_CubesFree = pp[0];
-	// set the counters of the used and free cubes
-	g_CoverInfo.nCubesInUse = 0;
-	g_CoverInfo.nCubesFree = nCubes;
+	// determine the size of the piece
+	// (the index entries are kept after the cubes, 
+	// so that they would not dilute the cubes in the cache)
+	TotalSize = nCubes*(s_OneCubeSize + sizeof(CubeIdx));
+	// allocate and clear memory for the piece
+	pChunk = (Cube *)malloc( TotalSize );
+	if ( pChunk == NULL )
+		return 0;
+	memset( pChunk, 0, TotalSize );
+	s_pCoverMemory[ s_nChunks++ ] = pChunk;
+	pIdx = (CubeIdx *)((char*)pChunk + nCubes*s_OneCubeSize);
 
-	// save the pointer to the allocated memory
-	s_pCoverMemory = pp;
+	// assign pointers to bit strings inside this piece and
+	// connect the cubes into the free list using Next pointers
+	// (the first cube of the piece becomes the head of the list)
+	for ( i = nCubes-1; i >= 0; i-- )
+	{
+		p = (Cube *)((char*)pChunk + i*s_OneCubeSize);
+		p->pCubeDataIn  = (word*)(p + 1);
+		p->pCubeDataOut = (word*)((char*)p->pCubeDataIn + s_OneInputSetSize);
+		p->pIdx = pIdx + i;
+		p->Next = s_CubesFree;
+		s_CubesFree = p;
+	}
 
-	assert ( g_CoverInfo.nCubesInUse + g_CoverInfo.nCubesFree == g_CoverInfo.nCubesAlloc );
+	// update the counters of the allocated and free cubes
+	g_CoverInfo.nCubesAlloc += nCubes;
+	g_CoverInfo.nCubesFree  += nCubes;
 
-	return nCubes*sizeof(Cube *) + TotalSize;
+	return TotalSize;
 }
 
 void DelocateCover()
 {
-	free( s_pCoverMemory[0] );
+	int i;
+	for ( i = 0; i < s_nChunks; i++ )
+		free( s_pCoverMemory[i] );
 	free( s_pCoverMemory );
+	s_pCoverMemory = NULL;
+	s_nChunks = 0;
+	s_CubesFree = NULL;
 }
 
 ///////////////////////////////////////////////////////////////////
@@ -152,6 +208,15 @@ void AddToFreeCubes( Cube * p )
 Cube * GetFreeCube()
 {
 	Cube * p;
+	// if there are no free cubes, grow the cover by one more piece
+	if ( s_CubesFree == NULL )
+	{
+		if ( AllocateCubeChunk( g_CoverInfo.nCubesAlloc/2 + ADDITIONAL_CUBES ) == 0 )
+		{
+			printf( "\nCannot allocate memory for more than %d cubes. Quitting...\n", g_CoverInfo.nCubesAlloc );
+			exit(1);
+		}
+	}
 	assert( s_CubesFree );
 	p = s_CubesFree;
 	s_CubesFree = s_CubesFree->Next;
@@ -160,6 +225,54 @@ Cube * GetFreeCube()
 	return p;
 }
 
+///////////////////////////////////////////////////////////////////
+///                      CUBE RECORDS                            ///
+///////////////////////////////////////////////////////////////////
+
+// the covers passed between the processes and read from the cache
+// are the arrays of records; the record of one cube contains the number 
+// of literals and the number of outputs (two ints) followed by the input 
+// and output bit data (nWordsIn + nWordsOut words)
+
+int CubeRecordSize()
+// returns the size of the record of one cube in bytes
+{
+	return 2*sizeof(int) + (g_CoverInfo.nWordsIn + g_CoverInfo.nWordsOut)*sizeof(word);
+}
+
+char * CubeRecordWrite( char * pRecord, int nLits, int nOuts, word * pIn, word * pOut )
+// writes the record of the cube with the given numbers and bit data;
+// returns the position of the next record
+{
+	int Counts[2];
+	Counts[0] = nLits;
+	Counts[1] = nOuts;
+	memcpy( pRecord, Counts, 2*sizeof(int) );
+	pRecord += 2*sizeof(int);
+	memcpy( pRecord, pIn, g_CoverInfo.nWordsIn*sizeof(word) );
+	pRecord += g_CoverInfo.nWordsIn*sizeof(word);
+	memcpy( pRecord, pOut, g_CoverInfo.nWordsOut*sizeof(word) );
+	pRecord += g_CoverInfo.nWordsOut*sizeof(word);
+	return pRecord;
+}
+
+char * CubeRecordRead( char * pRecord, Cube * p )
+// copies the numbers and the bit data of the record into the cube
+// (the other fields of the cube are not changed);
+// returns the position of the next record
+{
+	int Counts[2];
+	memcpy( Counts, pRecord, 2*sizeof(int) );
+	pRecord += 2*sizeof(int);
+	memcpy( p->pCubeDataIn, pRecord, g_CoverInfo.nWordsIn*sizeof(word) );
+	pRecord += g_CoverInfo.nWordsIn*sizeof(word);
+	memcpy( p->pCubeDataOut, pRecord, g_CoverInfo.nWordsOut*sizeof(word) );
+	pRecord += g_CoverInfo.nWordsOut*sizeof(word);
+	p->a = (short)Counts[0];
+	p->z = (short)Counts[1];
+	return pRecord;
+}
+
 ///////////////////////////////////////////////////////////////////
 ////////////              End of File             /////////////////
 ///////////////////////////////////////////////////////////////////
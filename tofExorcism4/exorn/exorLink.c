@@ -64,6 +64,16 @@ void ExorLinkCubeIteratorCleanUp( int fTakeLastGroup );
 // if fTakeLastGroup is 0, removes all cubes
 // if fTakeLastGroup is 1, does not store the last group
 
+unsigned ExorLinkCubeIteratorGroupMask();
+// returns the mask of the cubes in the current group (bit i stands for cube i)
+
+int ExorLinkCubesGenerate( Cube* pCubes, Cube* pC1, Cube* pC2, cubedist Dist );
+// generates all cubes, from which the groups are made, into the given cubes
+// returns the number of cubes, or 0 if the cubes have wrong distance
+
+void ExorLinkSetGroupOrder( int fMinLitFirst );
+// sets the order, in which the groups of ExorLink-3/4 are tried
+
 ////////////////////////////////////////////////////////////////////////
 ///                       EXTERNAL VARIABLES                         ///
 ////////////////////////////////////////////////////////////////////////
@@ -405,7 +415,7 @@ int ExorLinkCubeIteratorStart( Cube** pGroup, Cube* pC1, Cube* pC2, cubedist Dis
 		DiffVarWords[i] = ((2*pDiffVars[i]) >> LOGBPI) ;
 		DiffVarBits[i]  = ((2*pDiffVars[i]) & BPIMASK);
 		// clear this position
-		DammyBitData[ DiffVarWords[i] ] &= ~( 3 << DiffVarBits[i] );
+		DammyBitData[ DiffVarWords[i] ] &= ~( (word)3 << DiffVarBits[i] );
 	}
 
 	// extract the values from the cubes and create the mask of literals
@@ -521,13 +531,13 @@ int ExorLinkCubeIteratorStart( Cube** pGroup, Cube* pC1, Cube* pC2, cubedist Dis
 		for ( i = 0; i < nDiffVarsIn; i++ )
 		{
 			Value = DiffVarValues[i][ s_ELCubeRules[Dist][CubeNum][i] ];
-			ELCubes[CubeNum]->pCubeDataIn[ DiffVarWords[i] ] |= ( Value << DiffVarBits[i] );
+			ELCubes[CubeNum]->pCubeDataIn[ DiffVarWords[i] ] |= ( (word)Value << DiffVarBits[i] );
 		}
 
 		// assign the ID
 		ELCubes[CubeNum]->ID = g_CoverInfo.cIDs++;
 		// skip through zero-ID
-		if ( g_CoverInfo.cIDs == 256 )
+		if ( g_CoverInfo.cIDs == 0 )
 			g_CoverInfo.cIDs = 1;
 
 		// prepare the return array
@@ -643,13 +653,13 @@ int ExorLinkCubeIteratorNext( Cube** pGroup )
 			for ( i = 0; i < nDiffVarsIn; i++ )
 			{
 				Value = DiffVarValues[i][ s_ELCubeRules[nDist][CubeNum][i] ];
-				ELCubes[CubeNum]->pCubeDataIn[ DiffVarWords[i] ] |= ( Value << DiffVarBits[i] );
+				ELCubes[CubeNum]->pCubeDataIn[ DiffVarWords[i] ] |= ( (word)Value << DiffVarBits[i] );
 			}
 
 			// assign the ID
 			ELCubes[CubeNum]->ID = g_CoverInfo.cIDs++;
 			// skip through zero-ID
-			if ( g_CoverInfo.cIDs == 256 )
+			if ( g_CoverInfo.cIDs == 0 )
 				g_CoverInfo.cIDs = 1;
 
 		}
@@ -726,6 +736,92 @@ void ExorLinkCubeIteratorCleanUp( int fTakeLastGroup )
 	fWorking = 0;
 }
 
+void ExorLinkSetGroupOrder( int fMinLitFirst )
+// if the flag is 1, the groups of ExorLink-3/4 are tried starting from 
+// the group with the minimum number of literals; otherwise, starting from 
+// the group with the maximum number of literals (the default)
+{
+	assert( !fWorking );
+	fMinLitGroupsFirst[DIST3] = fMinLitFirst;
+	fMinLitGroupsFirst[DIST4] = fMinLitFirst;
+}
+
+unsigned ExorLinkCubeIteratorGroupMask()
+// returns the mask of the cubes in the current group; the cubes are numbered 
+// in the same way as by ExorLinkCubesGenerate() (bit i stands for cube i)
+{
+	assert( fWorking );
+	return (unsigned)LastGroup;
+}
+
+int ExorLinkCubesGenerate( Cube* pCubes, Cube* pC1, Cube* pC2, cubedist Dist )
+// generates all cubes, from which the groups of ExorLink of the given distance
+// are made, into the array pCubes[] provided by the caller (only the bit data 
+// and the number of literals are set); unlike the iterator, this function 
+// does not use the static variables, so several threads can call it at once;
+// returns the number of cubes, or 0 if the cubes have wrong distance
+{
+	int Vars[5], VarWords[5], VarBits[5], VarValues[4][3];
+	int * pVars, nVarsIn, Literals, Shift;
+	int nVars = Dist + 2;
+	word Mask;
+	Cube * pC;
+	int i, c, v;
+
+	// find what variables are different in these two cubes
+	if ( FindDiffVars( Vars, pC1, pC2 ) != nVars )
+		return 0;
+
+	// find the number of different input variables and their values
+	nVarsIn = ( Vars[0] >= 0 )? nVars: nVars-1;
+	pVars   = ( Vars[0] >= 0 )? Vars: Vars+1;
+	Mask = 0;
+	Literals = pC1->a;
+	for ( i = 0, Shift = 0; i < nVarsIn; i++, Shift += 4 )
+	{
+		VarWords[i] = ((2*pVars[i]) >> LOGBPI);
+		VarBits[i]  = ((2*pVars[i]) & BPIMASK);
+		VarValues[i][0] = ( pC1->pCubeDataIn[VarWords[i]] >> VarBits[i] ) & 3;
+		VarValues[i][1] = ( pC2->pCubeDataIn[VarWords[i]] >> VarBits[i] ) & 3;
+		VarValues[i][2] = VarValues[i][0] ^ VarValues[i][1];
+		if ( VarValues[i][0] != VAR_ABS )
+		{
+			Mask |= ( 1 << (Shift+0) );
+			Literals--;
+		}
+		if ( VarValues[i][1] != VAR_ABS )
+			Mask |= ( 1 << (Shift+1) );
+		if ( VarValues[i][2] != VAR_ABS )
+			Mask |= ( 1 << (Shift+2) );
+	}
+
+	// create the cubes in the same way as the iterator does
+	for ( c = 0; c < s_ELnCubes[Dist]; c++ )
+	{
+		pC = pCubes + c;
+		for ( i = 0; i < g_CoverInfo.nWordsIn; i++ )
+			pC->pCubeDataIn[i] = pC1->pCubeDataIn[i];
+		for ( i = 0; i < nVarsIn; i++ )
+		{
+			v = VarValues[i][ s_ELCubeRules[Dist][c][i] ];
+			pC->pCubeDataIn[ VarWords[i] ] &= ~( (word)3 << VarBits[i] );
+			pC->pCubeDataIn[ VarWords[i] ] |= ( (word)v << VarBits[i] );
+		}
+
+		v = ( Vars[0] >= 0 )? vs0: s_ELCubeRules[Dist][c][nVarsIn];
+		for ( i = 0; i < g_CoverInfo.nWordsOut; i++ )
+			if ( v == vs0 )
+				pC->pCubeDataOut[i] = pC1->pCubeDataOut[i];
+			else if ( v == vs1 )
+				pC->pCubeDataOut[i] = pC2->pCubeDataOut[i];
+			else
+				pC->pCubeDataOut[i] = pC1->pCubeDataOut[i] ^ pC2->pCubeDataOut[i];
+
+		pC->a = Literals + BitCount[ Mask & s_CubeLitMasks[Dist][c] ];
+	}
+	return s_ELnCubes[Dist];
+}
+
 	
 ///////////////////////////////////////////////////////////////////
 ////////////              End of File             /////////////////
@@ -26,6 +26,8 @@
 ////////////////////////////////////////////////////////////////////////
 
 #include "exor.h"
+#include <string.h>
+#include <pthread.h>
 
 ////////////////////////////////////////////////////////////////////////
 ///                       EXTERNAL VARIABLES                         ///
@@ -44,6 +46,8 @@ extern unsigned char BitCount[];
 extern int GetDistance( Cube* pC1, Cube* pC2 );
 // distance computation for two cubes
 extern int GetDistancePlus( Cube* pC1, Cube* pC2 );
+extern int ScanCloseCubes( Cube* p, int Dist, word* pArrIn, word* pArrOut, short* pArrLits, int iStart );
+// looks for a cube close to p in the dense arrays of cubes
 
 extern void ExorVar( Cube* pC, int Var, varvalue Val );
 
@@ -76,6 +80,13 @@ extern void ExorLinkCubeIteratorCleanUp( int fTakeLastGroup );
 // if fTakeLastGroup is 0, removes all cubes
 // if fTakeLastGroup is 1, does not store the last group
 
+extern unsigned ExorLinkCubeIteratorGroupMask();
+// returns the mask of the cubes in the current group (bit i stands for cube i)
+
+extern int ExorLinkCubesGenerate( Cube* pCubes, Cube* pC1, Cube* pC2, cubedist Dist );
+// generates all cubes, from which the groups are made, into the given cubes
+// returns the number of cubes, or 0 if the cubes have wrong distance
+
 ////////////////////////////////////////////////////////////////////////
 ///                    FUNCTIONS OF THIS MODULE                      ///
 ////////////////////////////////////////////////////////////////////////
@@ -113,6 +124,19 @@ void DelocateCubeSets();
 void CubeInsert( Cube* p );
 Cube* CubeExtract( Cube* p );
 
+// the dense arrays of the list
+static int  ActMakeRoom();
+static Cube* ActScanStart();
+static Cube* ActScanNext();
+
+// the index of cubes in the storage
+static void IndexInsert( Cube* p );
+static void IndexRemove( Cube* p );
+static int  IndexResize();
+// iterates through the cubes that can be close to the given one
+static int  IndexCollectStart( Cube* p );
+static Cube* IndexCollectNext();
+
 ////////////////////////////////////////////////////////////////////////
 // Cube Set Iterator
 Cube* IterCubeSetStart();
@@ -125,7 +149,7 @@ Cube* IterCubeSetNext();
 // cube adjacency queques
 
 // adjacency queque allocation/delocation procedures
-int AllocateQueques( int nPlaces );
+int AllocateQueques( int nPlaces, int nPlacesMax );
 void DelocateQueques();
 
 // conditional adding cube pairs to queques
@@ -139,8 +163,20 @@ static void NewRangeInsertCubePair( cubedist Dist, Cube* p1, Cube* p2 );
 static void MarkSet();
 static void MarkRewind();
 
+// the batches of cube pairs evaluated in parallel
+int AllocatePairBatch( int nThreads );
+void DelocatePairBatch();
+static int  PairBatchStart( cubedist Dist, Cube** ppC1, Cube** ppC2 );
+static int  PairBatchNext();
+static int  PairBatchFill();
+static void* PairBatchThread( void* pArg );
+static unsigned PairEvaluate( Cube* pCubes, Cube* pC1, Cube* pC2, int iBeg );
+static int  PairCubeIsClose( Cube* p, Cube* pC1, Cube* pC2, int iBeg );
+
 void PrintQuequeStats();
 int GetQuequeStats( cubedist Dist );
+// randomly permutes the cube pairs waiting in the queques
+void ShuffleQueques( unsigned Seed );
 
 // iterating through the queque (with authomatic garbage collection)
 // start an iterator through cubes of dist CubeDist,
@@ -153,10 +189,12 @@ int IteratorCubePairNext();
 ///                      EXPORTED VARIABLES                          ///
 ////////////////////////////////////////////////////////////////////////`
 
-// the number of allocated places
+// the number of allocated places (in all queques)
 int s_nPosAlloc;
 // the maximum number of occupied places
 int s_nPosMax[3];
+// the number of cube pairs not enquequed because of the memory budget
+int s_nPosDropped;
 
 ////////////////////////////////////////////////////////////////////////
 ///                      Minimization Strategy                       ///
@@ -191,6 +229,109 @@ int s_nPosMax[3];
 // Cube set is a list of cubes
 Cube* s_List;
 
+///////////////////////////////////////////////////////////////////////////
+// the list in the form of dense arrays
+///////////////////////////////////////////////////////////////////////////
+// the cubes of the list are also kept in parallel arrays indexed by 
+// the position of the cube (Cube::Pos); because the cubes are appended 
+// at the end, going from the end to the beginning follows the order 
+// of the list; the extracted cubes leave holes, which are removed when 
+// they take a quarter of the arrays; this way, the scans of the cover 
+// are sequential
+
+static Cube** s_pActCubes;  // the cubes (NULL if the cube was extracted)
+static short* s_pActLits;   // the numbers of literals
+static word* s_pActIn;      // the input parts (nWordsIn words per cube)
+static word* s_pActOut;     // the output parts (nWordsOut words per cube)
+static int s_nActs;         // the number of used positions
+static int s_nActsAlloc;    // the number of allocated positions
+static int s_nActsHoles;    // the number of extracted cubes among the used positions
+static int s_nActsRemoved;  // the number of times the holes have been removed
+static int s_ActScan;       // the current position of the scan
+
+// the number of literals written for the holes
+// (it is so large that the holes are never close to any cube)
+#define ACT_HOLE_LITS    -10000
+
+///////////////////////////////////////////////////////////////////////////
+// the index of cubes in the list
+///////////////////////////////////////////////////////////////////////////
+// the input variables are split into groups of adjacent variables; 
+// each group has a hash table, in which the cubes are binned by 
+// the hash value of their literals in this group; since the cubes
+// at distance D differ in at most D variables, they have the same 
+// literals in at least (s_nGroups - D) groups, and so in at least one
+// of any (D + 1) groups; it is enough to look only at the cubes 
+// that share the bins with the given cube in the (D + 1) groups 
+// whose bins are the smallest
+
+// the number of variable groups
+static int s_nGroups;
+// the first/last words of the input part covered by each group
+static int s_GroupWordBeg[INDEX_GROUPS];
+static int s_GroupWordEnd[INDEX_GROUPS];
+// the masks of the group bits in the first/last words
+static word s_GroupMaskBeg[INDEX_GROUPS];
+static word s_GroupMaskEnd[INDEX_GROUPS];
+
+// the hash tables (one for each group) and the numbers of cubes in the bins
+static Cube** s_pBins[INDEX_GROUPS];
+static int* s_pBinSizes[INDEX_GROUPS];
+static int s_nBins;       // the number of bins (the power of 2)
+static int s_nIndexed;    // the number of cubes in the index
+
+// the counter of queries
+static unsigned s_cQueries;
+
+// the cube, for which the close cubes are looked for, and the largest distance of interest
+static Cube* s_pCandCube;
+static int s_nCandDist;
+
+// the state of the merge of the bins, which can contain cubes close to the given one
+static int s_nCandBins;                     // the number of bins being merged
+static int s_CandGroups[INDEX_GROUPS];      // the groups of these bins
+static Cube* s_pCandCurs[INDEX_GROUPS];     // the current cubes in these bins
+static unsigned s_CandHash[INDEX_GROUPS];   // the hash values of the given cube
+
+///////////////////////////////////////////////////////////////////////////
+// the batches of cube pairs evaluated in parallel
+///////////////////////////////////////////////////////////////////////////
+// with several threads, the pairs of ExorLink-3 and ExorLink-4 are taken
+// from the queque in batches; the threads generate all cubes of the groups 
+// of each pair and look for the cubes in the list, which are dist-0 or 
+// dist-1 removed from them; a group, none of whose cubes has such a cube, 
+// cannot lead to improvement or reshaping; after that, the pairs are given 
+// to ExorLink one by one in the order of the queque: the pairs changed by 
+// the previous pairs of the batch are skipped, the cubes are checked again
+// only against the cubes added to the list since the batch was evaluated,
+// and ExorLink does not try the groups found useless (the pairs, whose 
+// groups are all useless, are idle and are not tried at all); so the result
+// does not depend on the number of threads
+
+// the number of pairs in the batch per thread
+#define PAIR_BATCH        256
+// the largest number of threads
+#define PAIR_THREADS_MAX  64
+
+static int s_nThreads;          // the number of threads
+static int s_nPairs;            // the number of pairs in the batch
+static int s_nPairsAlloc;       // the number of allocated pairs
+static int s_iPair;             // the next pair to be given to ExorLink
+static Cube** s_pPairC1;        // the first cubes of the pairs
+static Cube** s_pPairC2;        // the second cubes of the pairs
+static unsigned* s_pPairID1;    // the IDs of the first cubes
+static unsigned* s_pPairID2;    // the IDs of the second cubes
+static unsigned* s_pPairMasks;  // the masks of the ExorLinked cubes of the pairs having close cubes
+static unsigned s_PairMask;     // this mask for the pair given to ExorLink
+static int s_fPairsLeft;        // 1 if the queque may have more pairs
+static int s_fPairsStarted;     // 1 if the queque iterator has been started
+static Cube *s_pPairNext1, *s_pPairNext2; // the pair taken from the queque
+static Cube **s_ppPairC1, **s_ppPairC2;   // the pick-up place for the pairs
+static int s_nPairActs;         // the used positions of the dense arrays when the batch was evaluated
+static int s_nPairRemoved;      // the number of times the holes were removed at that moment
+static Cube* s_pPairCubes;      // the ExorLinked cubes (32 for each thread)
+static word* s_pPairData;       // the bit data of these cubes
+
 ///////////////////////////////////////////////////////////////////////////
 // undo information
 ///////////////////////////////////////////////////////////////////////////
@@ -203,7 +344,8 @@ static struct
 	int PrevPz;
 	int Var;      // the number of variable that was changed
 	int Value;    // the value what was there
-	int PrevID;   // the previous ID of the removed cube
+	unsigned PrevID;  // the previous ID of the removed cube
+	unsigned PrevPID; // the previous ID of the modified cube
 } s_ChangeStore;
 ///////////////////////////////////////////////////////////////////////////
 
@@ -226,6 +368,8 @@ int s_fDecreaseLiterals = 0;
 static int s_cEnquequed;
 static int s_cAttempts;
 static int s_cReshapes;
+static int s_cWasted;  // the attempts on stale pairs (the distance has changed)
+static int s_cIdle;    // the attempts on pairs found idle by the threads
 
 // the number of cubes before ExorLink starts
 static int s_nCubesBefore;
@@ -269,6 +413,7 @@ int IterativelyApplyExorLink2( char fDistEnable )
 	s_cEnquequed = GetQuequeStats( s_Dist );
 	s_cAttempts  = 0;
 	s_cReshapes  = 0;
+	s_cWasted    = 0;
 
 	// remember the number of cubes before minimization
 	s_nCubesBefore = g_CoverInfo.nCubesInUse;
@@ -277,7 +422,9 @@ int IterativelyApplyExorLink2( char fDistEnable )
 	{
 		s_cAttempts++;
 		// start ExorLink of the given Distance
-		if ( ExorLinkCubeIteratorStart( s_CubeGroup, s_pC1, s_pC2, s_Dist ) )
+		if ( !ExorLinkCubeIteratorStart( s_CubeGroup, s_pC1, s_pC2, s_Dist ) )
+			s_cWasted++;
+		else
 		{
 			// extract old cubes from storage (to prevent EXORing with their derivitives)
 			CubeExtract( s_pC1 );
@@ -365,6 +512,7 @@ SUCCESS:
 	printf( "  Att= %4d", s_cAttempts );
 	printf( "  Resh= %4d", s_cReshapes );
 	printf( "  NoResh= %4d", s_cAttempts - s_cReshapes );
+	printf( "  Wasted= %4d", s_cWasted );
 	printf( "  Cubes= %3d", g_CoverInfo.nCubesInUse );
 	printf( "  (%d)", s_nCubesBefore - g_CoverInfo.nCubesInUse );
 	printf( "\n" );
@@ -389,15 +537,29 @@ int IterativelyApplyExorLink3( char fDistEnable )
 	s_cEnquequed = GetQuequeStats( s_Dist );
 	s_cAttempts  = 0;
 	s_cReshapes  = 0;
+	s_cWasted    = 0;
+	s_cIdle      = 0;
 
 	// remember the number of cubes before minimization
 	s_nCubesBefore = g_CoverInfo.nCubesInUse;
 
-	for ( z = IteratorCubePairStart( s_Dist, &s_pC1, &s_pC2 ); z; z = IteratorCubePairNext() )
+	for ( z = PairBatchStart( s_Dist, &s_pC1, &s_pC2 ); z; z = PairBatchNext() )
 	{
 		s_cAttempts++;
+		if ( s_PairMask == 0 )
+		{ // none of the groups can lead to improvement
+			// return the old cubes back to storage, as if ExorLink has been tried
+			CubeExtract( s_pC1 );
+			CubeExtract( s_pC2 );
+			CubeInsert( s_pC1 );
+			CubeInsert( s_pC2 );
+			s_cIdle++;
+			continue;
+		}
 		// start ExorLink of the given Distance
-		if ( ExorLinkCubeIteratorStart( s_CubeGroup, s_pC1, s_pC2, s_Dist ) )
+		if ( !ExorLinkCubeIteratorStart( s_CubeGroup, s_pC1, s_pC2, s_Dist ) )
+			s_cWasted++;
+		else
 		{
 			// extract old cubes from storage (to prevent EXORing with their derivitives)
 			CubeExtract( s_pC1 );
@@ -409,7 +571,16 @@ int IterativelyApplyExorLink3( char fDistEnable )
 			// check cube groups one by one
 			s_GroupCounter = 0;
 			do 	
-			{	// check the cubes of this group one by one
+			{	// skip the group, if the threads have found that its cubes have no close cubes
+				if ( (ExorLinkCubeIteratorGroupMask() & s_PairMask) == 0 )
+				{ // mark the cubes as checked
+					for ( c = 0; c < 3; c++ )
+						s_CubeGroup[c]->fMark = 1;
+					s_GroupCounter++;
+					MarkRewind();
+					continue;
+				}
+				// check the cubes of this group one by one
 				for ( c = 0; c < 3; c++ )
 				if ( !s_CubeGroup[c]->fMark ) // this cube has not yet been checked
 				{
@@ -480,6 +651,9 @@ END_OF_LOOP: {}
 	printf( "  Att= %4d", s_cAttempts );
 	printf( "  Resh= %4d", s_cReshapes );
 	printf( "  NoResh= %4d", s_cAttempts - s_cReshapes );
+	printf( "  Wasted= %4d", s_cWasted );
+	if ( s_nThreads > 1 )
+	printf( "  Idle= %4d", s_cIdle );
 	printf( "  Cubes= %3d", g_CoverInfo.nCubesInUse );
 	printf( "  (%d)", s_nCubesBefore - g_CoverInfo.nCubesInUse );
 	printf( "\n" );
@@ -504,15 +678,29 @@ int IterativelyApplyExorLink4( char fDistEnable )
 	s_cEnquequed = GetQuequeStats( s_Dist );
 	s_cAttempts  = 0;
 	s_cReshapes  = 0;
+	s_cWasted    = 0;
+	s_cIdle      = 0;
 
 	// remember the number of cubes before minimization
 	s_nCubesBefore = g_CoverInfo.nCubesInUse;
 
-	for ( z = IteratorCubePairStart( s_Dist, &s_pC1, &s_pC2 ); z; z = IteratorCubePairNext() )
+	for ( z = PairBatchStart( s_Dist, &s_pC1, &s_pC2 ); z; z = PairBatchNext() )
 	{
 		s_cAttempts++;
+		if ( s_PairMask == 0 )
+		{ // none of the groups can lead to improvement
+			// return the old cubes back to storage, as if ExorLink has been tried
+			CubeExtract( s_pC1 );
+			CubeExtract( s_pC2 );
+			CubeInsert( s_pC1 );
+			CubeInsert( s_pC2 );
+			s_cIdle++;
+			continue;
+		}
 		// start ExorLink of the given Distance
-		if ( ExorLinkCubeIteratorStart( s_CubeGroup, s_pC1, s_pC2, s_Dist ) )
+		if ( !ExorLinkCubeIteratorStart( s_CubeGroup, s_pC1, s_pC2, s_Dist ) )
+			s_cWasted++;
+		else
 		{
 			// extract old cubes from storage (to prevent EXORing with their derivitives)
 			CubeExtract( s_pC1 );
@@ -523,7 +711,15 @@ int IterativelyApplyExorLink4( char fDistEnable )
 
 			// check cube groups one by one
 			do 	
-			{	// check the cubes of this group one by one
+			{	// skip the group, if the threads have found that its cubes have no close cubes
+				if ( (ExorLinkCubeIteratorGroupMask() & s_PairMask) == 0 )
+				{ // mark the cubes as checked
+					for ( c = 0; c < 4; c++ )
+						s_CubeGroup[c]->fMark = 1;
+					MarkRewind();
+					continue;
+				}
+				// check the cubes of this group one by one
 				s_GainTotal = 0;
 				for ( c = 0; c < 4; c++ )
 				if ( !s_CubeGroup[c]->fMark ) // this cube has not yet been checked
@@ -589,6 +785,9 @@ END_OF_LOOP: {}
 	printf( "  Att= %4d", s_cAttempts );
 	printf( "  Resh= %4d", s_cReshapes );
 	printf( "  NoResh= %4d", s_cAttempts - s_cReshapes );
+	printf( "  Wasted= %4d", s_cWasted );
+	if ( s_nThreads > 1 )
+	printf( "  Idle= %4d", s_cIdle );
 	printf( "  Cubes= %3d", g_CoverInfo.nCubesInUse );
 	printf( "  (%d)", s_nCubesBefore - g_CoverInfo.nCubesInUse );
 	printf( "\n" );
@@ -614,10 +813,16 @@ int CheckForCloseCubes( Cube* p, int fAddCube )
 // returns the number of cubes gained in the process of reduction;
 // if an adjacent cube is not found, inserts the cube only if (fAddCube==1)!!!
 {
+	int fIndex;
+
 	// start the new range
 	NewRangeReset();
 
-	for ( s_q = s_List; s_q; s_q = s_q->Next )
+	// look only at the cubes that can be close to p, if the index helps,
+	// otherwise look at all cubes in the list
+	fIndex = IndexCollectStart( p );
+	for ( s_q = fIndex? IndexCollectNext(): ActScanStart(); s_q; 
+		  s_q = fIndex? IndexCollectNext(): ActScanNext() )
 	{
 		s_Distance = GetDistancePlus( p, s_q );
 		if ( s_Distance > 4 )
@@ -651,6 +856,7 @@ int CheckForCloseCubes( Cube* p, int fAddCube )
 			s_ChangeStore.Var    = s_DiffVarNum;
 			s_ChangeStore.Value  = s_DiffVarValueQ;
 			s_ChangeStore.PrevID = s_q->ID;
+			s_ChangeStore.PrevPID = p->ID;
 			//////////////////////////////////////////////////////////
 
 			CubeExtract( s_q );
@@ -684,6 +890,13 @@ int CheckForCloseCubes( Cube* p, int fAddCube )
 			// move q to the free cube list
 			AddToFreeCubes( s_q );
 
+			// p has changed in place - give it a new ID, 
+			// so that the pairs enqueued with its old contents become stale
+			p->ID = g_CoverInfo.cIDs++;
+			// skip through zero-ID
+			if ( g_CoverInfo.cIDs == 0 )
+				g_CoverInfo.cIDs = 1;
+
 			// make sure that nobody with use the pairs created so far
 //			NewRangeReset();
 			// call the function again for the new cube
@@ -738,6 +951,8 @@ void UndoRecentChanges()
 		p->z = s_ChangeStore.PrevPz;
 		// p->a did not change
 	}
+	// restore the ID
+	p->ID = s_ChangeStore.PrevPID;
 }
 
 ///////////////////////////////////////////////////////////////////
@@ -753,12 +968,71 @@ void UndoRecentChanges()
 
 int AllocateCubeSets( int nVarsIn, int nVarsOut )
 {
+	int g, VarBeg, VarEnd;
+
 	s_List = NULL;
-	return 4;
+
+	// split the input variables into groups
+	s_nGroups = (nVarsIn < INDEX_GROUPS)? nVarsIn: INDEX_GROUPS;
+	for ( g = 0; g < s_nGroups; g++ )
+	{
+		// the group includes the variables [VarBeg, VarEnd)
+		VarBeg = g * nVarsIn / s_nGroups;
+		VarEnd = (g+1) * nVarsIn / s_nGroups;
+		// each variable takes two bits
+		s_GroupWordBeg[g] = VarWord( 2*VarBeg );
+		s_GroupWordEnd[g] = VarWord( 2*VarEnd-1 );
+		s_GroupMaskBeg[g] = ((word)~0) << VarBit( 2*VarBeg );
+		s_GroupMaskEnd[g] = ((word)~0) >> (BPI-1 - VarBit( 2*VarEnd-1 ));
+		if ( s_GroupWordBeg[g] == s_GroupWordEnd[g] )
+			s_GroupMaskBeg[g] = s_GroupMaskEnd[g] = s_GroupMaskBeg[g] & s_GroupMaskEnd[g];
+	}
+
+	// start the dense arrays
+	s_nActs = 0;
+	s_nActsHoles = 0;
+	s_nActsAlloc = g_CoverInfo.nCubesAlloc;
+	s_pActCubes = (Cube**) malloc( s_nActsAlloc * sizeof(Cube*) );
+	s_pActLits  = (short*) malloc( s_nActsAlloc * sizeof(short) );
+	s_pActIn    = (word*) malloc( s_nActsAlloc * g_CoverInfo.nWordsIn * sizeof(word) );
+	s_pActOut   = (word*) malloc( s_nActsAlloc * g_CoverInfo.nWordsOut * sizeof(word) );
+	if ( s_pActCubes == NULL || s_pActLits == NULL || s_pActIn == NULL || s_pActOut == NULL )
+		return 0;
+
+	// start the hash tables
+	s_nBins = 0;
+	s_nIndexed = 0;
+	s_cQueries = 0;
+	for ( g = 0; g < s_nGroups; g++ )
+	{
+		s_pBins[g] = NULL;
+		s_pBinSizes[g] = NULL;
+	}
+	if ( !IndexResize() )
+		return 0;
+
+	return s_nGroups * s_nBins * (sizeof(Cube*) + sizeof(int)) + s_nActsAlloc * 
+		(sizeof(Cube*) + sizeof(short) + (g_CoverInfo.nWordsIn + g_CoverInfo.nWordsOut) * sizeof(word));
 }
 
 void DelocateCubeSets()
 {
+	int g;
+	for ( g = 0; g < s_nGroups; g++ )
+	{
+		free( s_pBins[g] );
+		free( s_pBinSizes[g] );
+		s_pBins[g] = NULL;
+		s_pBinSizes[g] = NULL;
+	}
+	free( s_pActCubes );
+	free( s_pActLits );
+	free( s_pActIn );
+	free( s_pActOut );
+	s_pActCubes = NULL;
+	s_pActLits  = NULL;
+	s_pActIn    = NULL;
+	s_pActOut   = NULL;
 }
 
 ///////////////////////////////////////////////////////////////////
@@ -771,6 +1045,25 @@ void CubeInsert( Cube* p )
 	assert( p->Prev == NULL && p->Next == NULL );
 	assert( p->ID );
 
+	// make sure the cube can be added at the end of the dense arrays
+	// and that the holes do not take more than a quarter of them
+	if ( (s_nActs == s_nActsAlloc || s_nActsHoles > s_nActs / 4) && !ActMakeRoom() )
+	{
+		printf( "\nUnexpected memory allocation problem. Quitting...\n" );
+		exit(1);
+	}
+	p->Pos = s_nActs;
+
+	// add the cube to the index
+	IndexInsert( p );
+
+	// add the cube to the dense arrays
+	s_pActCubes[p->Pos] = p;
+	s_pActLits[p->Pos]  = p->a;
+	memcpy( s_pActIn + p->Pos * g_CoverInfo.nWordsIn, p->pCubeDataIn, g_CoverInfo.nWordsIn * sizeof(word) );
+	memcpy( s_pActOut + p->Pos * g_CoverInfo.nWordsOut, p->pCubeDataOut, g_CoverInfo.nWordsOut * sizeof(word) );
+	s_nActs++;
+
 	if ( s_List == NULL )
 		s_List = p;
 	else
@@ -806,10 +1099,311 @@ Cube* CubeExtract( Cube* p )
 	p->Prev = NULL;
 	p->Next = NULL;
 
+	// remove the cube from the index
+	IndexRemove( p );
+
+	// leave the hole in the dense arrays
+	s_pActCubes[p->Pos] = NULL;
+	s_pActLits[p->Pos]  = ACT_HOLE_LITS;
+	s_nActsHoles++;
+
 	g_CoverInfo.nCubesInUse--;
 	return p;
 }
 
+///////////////////////////////////////////////////////////////////
+///                  DENSE ARRAYS OF THE LIST                   ///
+///////////////////////////////////////////////////////////////////
+
+static int ActMakeRoom()
+// makes room for one more cube at the end of the dense arrays by removing 
+// the holes, if they take a quarter of the arrays, or by growing the arrays;
+// returns 0 if memory cannot be allocated
+{
+	int nWordsIn  = g_CoverInfo.nWordsIn;
+	int nWordsOut = g_CoverInfo.nWordsOut;
+	int nActsAlloc, i, k;
+	void* pTemp;
+
+	if ( s_nActsHoles > 0 && s_nActsHoles >= s_nActs / 4 )
+	{ // remove the holes, keeping the order of the cubes
+		for ( i = k = 0; i < s_nActs; i++ )
+		{
+			if ( s_pActCubes[i] == NULL )
+				continue;
+			if ( k < i )
+			{
+				s_pActCubes[k] = s_pActCubes[i];
+				s_pActLits[k]  = s_pActLits[i];
+				memcpy( s_pActIn + k * nWordsIn, s_pActIn + i * nWordsIn, nWordsIn * sizeof(word) );
+				memcpy( s_pActOut + k * nWordsOut, s_pActOut + i * nWordsOut, nWordsOut * sizeof(word) );
+				s_pActCubes[k]->Pos = k;
+			}
+			k++;
+		}
+		s_nActs = k;
+		s_nActsHoles = 0;
+		s_nActsRemoved++;
+		return 1;
+	}
+
+	// grow the arrays
+	nActsAlloc = 2 * s_nActsAlloc + ADDITIONAL_CUBES;
+	if ( (pTemp = realloc( s_pActCubes, nActsAlloc * sizeof(Cube*) )) == NULL )
+		return 0;
+	s_pActCubes = (Cube**) pTemp;
+	if ( (pTemp = realloc( s_pActLits, nActsAlloc * sizeof(short) )) == NULL )
+		return 0;
+	s_pActLits = (short*) pTemp;
+	if ( (pTemp = realloc( s_pActIn, nActsAlloc * nWordsIn * sizeof(word) )) == NULL )
+		return 0;
+	s_pActIn = (word*) pTemp;
+	if ( (pTemp = realloc( s_pActOut, nActsAlloc * nWordsOut * sizeof(word) )) == NULL )
+		return 0;
+	s_pActOut = (word*) pTemp;
+	s_nActsAlloc = nActsAlloc;
+	return 1;
+}
+
+static Cube* ActScanStart()
+// starts the scan of the dense arrays in the order of the list;
+// returns the first cube that can be close to the given one
+// (the cube and the distance should be set by IndexCollectStart())
+{
+	s_ActScan = s_nActs;
+	return ActScanNext();
+}
+
+static Cube* ActScanNext()
+// returns the next cube that can be close to the given one, or NULL if there is none;
+// this cube is not farther from the given one than the largest distance of interest
+// (the holes are skipped, because they have ACT_HOLE_LITS literals)
+{
+	s_ActScan = ScanCloseCubes( s_pCandCube, s_nCandDist, s_pActIn, s_pActOut, s_pActLits, s_ActScan );
+	if ( s_ActScan < 0 )
+	{
+		s_ActScan = 0;
+		return NULL;
+	}
+	return s_pActCubes[s_ActScan];
+}
+
+///////////////////////////////////////////////////////////////////
+///                       INDEX OF CUBES                        ///
+///////////////////////////////////////////////////////////////////
+
+static unsigned GroupHash( Cube* p, int g )
+// computes the hash value of the literals of the cube in the group
+{
+	unsigned Hash;
+	word Data;
+	int w;
+
+	Hash = 0;
+	for ( w = s_GroupWordBeg[g]; w <= s_GroupWordEnd[g]; w++ )
+	{
+		Data = p->pCubeDataIn[w];
+		if ( w == s_GroupWordBeg[g] )
+			Data &= s_GroupMaskBeg[g];
+		if ( w == s_GroupWordEnd[g] )
+			Data &= s_GroupMaskEnd[g];
+#if BPI == 64
+		Data ^= Data >> 32;
+#endif
+		Hash = (Hash ^ (unsigned)Data) * 0x9E3779B1;
+	}
+	return Hash ^ (Hash >> 16);
+}
+
+static void BinAdd( Cube* p, int g )
+// adds the cube to the bin of group g
+{
+	CubeIdx* pI = p->pIdx;
+	int Bin = pI->Hash[g] & (s_nBins-1);
+
+	pI->PrevH[g] = NULL;
+	pI->NextH[g] = s_pBins[g][Bin];
+	if ( s_pBins[g][Bin] )
+		s_pBins[g][Bin]->pIdx->PrevH[g] = p;
+	s_pBins[g][Bin] = p;
+	s_pBinSizes[g][Bin]++;
+}
+
+static void IndexInsert( Cube* p )
+// adds the cube to the hash tables
+// (should be called before the cube is added to the list)
+{
+	int g;
+
+	// resize the tables if they are too full
+	if ( s_nIndexed >= s_nBins && !IndexResize() )
+	{
+		printf( "\nUnexpected memory allocation problem. Quitting...\n" );
+		exit(1);
+	}
+
+	for ( g = 0; g < s_nGroups; g++ )
+	{
+		p->pIdx->Hash[g] = GroupHash( p, g );
+		BinAdd( p, g );
+	}
+	s_nIndexed++;
+}
+
+static void IndexRemove( Cube* p )
+// removes the cube from the hash tables
+{
+	CubeIdx* pI = p->pIdx;
+	int g, Bin;
+
+	for ( g = 0; g < s_nGroups; g++ )
+	{
+		Bin = pI->Hash[g] & (s_nBins-1);
+		if ( pI->PrevH[g] )
+			pI->PrevH[g]->pIdx->NextH[g] = pI->NextH[g];
+		else
+			s_pBins[g][Bin] = pI->NextH[g];
+		if ( pI->NextH[g] )
+			pI->NextH[g]->pIdx->PrevH[g] = pI->PrevH[g];
+		s_pBinSizes[g][Bin]--;
+
+		pI->PrevH[g] = NULL;
+		pI->NextH[g] = NULL;
+	}
+	s_nIndexed--;
+}
+
+static int IndexResize()
+// doubles the number of bins and rehashes the cubes in the list
+// returns 0 if memory cannot be allocated
+{
+	Cube* p;
+	int nBinsNew, g, i;
+
+	nBinsNew = (s_nBins == 0)? 1024: 2 * s_nBins;
+	for ( g = 0; g < s_nGroups; g++ )
+	{
+		free( s_pBins[g] );
+		free( s_pBinSizes[g] );
+		s_pBins[g] = (Cube**) calloc( nBinsNew, sizeof(Cube*) );
+		s_pBinSizes[g] = (int*) calloc( nBinsNew, sizeof(int) );
+		if ( s_pBins[g] == NULL || s_pBinSizes[g] == NULL )
+			return 0;
+	}
+	s_nBins = nBinsNew;
+
+	// add the cubes of the list to the new bins, starting from the end of the list,
+	// so that the bins are ordered by the decreasing position, as the list is
+	for ( i = 0; i < s_nActs; i++ )
+		if ( (p = s_pActCubes[i]) )
+			for ( g = 0; g < s_nGroups; g++ )
+				BinAdd( p, g );
+	return 1;
+}
+
+static int IndexCollectStart( Cube* p )
+// starts merging the bins with the cubes that can be close to p;
+// returns 0 if the index does not help and all cubes should be looked at
+// (in both cases, remembers the cube and the largest distance of interest)
+{
+	unsigned Hash[INDEX_GROUPS];
+	int Sizes[INDEX_GROUPS];
+	int Groups[INDEX_GROUPS];
+	Cube* q;
+	int Dist, nVisits, g, i, k;
+
+	// determine the largest distance of interest
+	if ( s_fDistEnable4 )
+		Dist = 4;
+	else if ( s_fDistEnable3 )
+		Dist = 3;
+	else if ( s_fDistEnable2 )
+		Dist = 2;
+	else
+		Dist = 1;
+	s_pCandCube = p;
+	s_nCandDist = Dist;
+
+	// the index works if the cubes agree in at least one group
+	if ( Dist >= s_nGroups )
+		return 0;
+
+	// sort the groups by the size of the bins the cube falls into
+	for ( g = 0; g < s_nGroups; g++ )
+	{
+		Hash[g] = GroupHash( p, g );
+		Sizes[g] = s_pBinSizes[g][Hash[g] & (s_nBins-1)];
+		for ( i = g; i > 0 && Sizes[Groups[i-1]] > Sizes[g]; i-- )
+			Groups[i] = Groups[i-1];
+		Groups[i] = g;
+	}
+
+	// find how many cubes should be visited using the index;
+	// walking the bins costs about as much as computing the distance 
+	// of a short cube, so the index is used only if it saves a lot
+	nVisits = 0;
+	for ( k = 0; k <= Dist; k++ )
+		nVisits += Sizes[Groups[k]];
+	if ( nVisits >= g_CoverInfo.nCubesInUse / 4 )
+		return 0;
+
+	// each cube is returned only once
+	if ( ++s_cQueries == 0 )
+	{ // the counter has wrapped around - clean the old marks
+		for ( q = s_List; q; q = q->Next )
+			q->pIdx->Query = 0;
+		s_cQueries = 1;
+	}
+
+	// start merging the non-empty bins among the smallest ones
+	s_nCandBins = 0;
+	for ( k = 0; k <= Dist; k++ )
+	{
+		g = Groups[k];
+		if ( s_pBins[g][Hash[g] & (s_nBins-1)] == NULL )
+			continue;
+		s_CandGroups[s_nCandBins] = g;
+		s_CandHash[s_nCandBins] = Hash[g];
+		s_pCandCurs[s_nCandBins++] = s_pBins[g][Hash[g] & (s_nBins-1)];
+	}
+	return 1;
+}
+
+static Cube* IndexCollectNext()
+// returns the next cube that can be close to the given one, or NULL if there is none;
+// the bins are ordered by the decreasing position, so merging them 
+// gives the cubes in the order, in which they appear in the list
+{
+	Cube* q;
+	int g, i, k;
+	while ( s_nCandBins > 0 )
+	{
+		// find the most recent cube among the current ones
+		for ( i = 0, k = 1; k < s_nCandBins; k++ )
+			if ( s_pCandCurs[i]->Pos < s_pCandCurs[k]->Pos )
+				i = k;
+		q = s_pCandCurs[i];
+		g = s_CandGroups[i];
+		// skip the cubes from other groups and the cubes already seen
+		k = ( q->pIdx->Hash[g] != s_CandHash[i] || q->pIdx->Query == s_cQueries );
+		// move to the next cube in this bin
+		if ( (s_pCandCurs[i] = q->pIdx->NextH[g]) == NULL )
+		{
+			s_nCandBins--;
+			s_pCandCurs[i]  = s_pCandCurs[s_nCandBins];
+			s_CandGroups[i] = s_CandGroups[s_nCandBins];
+			s_CandHash[i]   = s_CandHash[s_nCandBins];
+		}
+		if ( k )
+			continue;
+		q->pIdx->Query = s_cQueries;
+		// the number of literals cannot differ by more than the distance
+		if ( q->a - s_pCandCube->a <= s_nCandDist && s_pCandCube->a - q->a <= s_nCandDist )
+			return q;
+	}
+	return NULL;
+}
+
 ///////////////////////////////////////////////////////////////////
 ///                       CUBE ITERATOR                         ///
 ///////////////////////////////////////////////////////////////////
@@ -849,17 +1443,24 @@ typedef struct
 {
 	Cube** pC1;      // the pointer to the first cube
 	Cube** pC2;      // the pointer to the second cube
-	byte*  ID1;      // the ID of the first cube
-	byte*  ID2;      // the ID of the second cube
+	unsigned* ID1;   // the ID of the first cube
+	unsigned* ID2;   // the ID of the second cube
 	int  PosOut;     // extract position
 	int  PosIn;      // insert position
 	int  PosCur;     // temporary insert position
 	int  PosMark;    // the marked position
 	int  fEmpty;     // this flag is 1 if there is nothing in the queque
+	int  nPosAlloc;  // the number of allocated places
 } que;
 
 static que s_Que[3];  // Dist-2, Dist-3, Dist-4 queques
 
+// the largest number of places one queque can grow to
+static int s_nPosBudget;
+
+// doubling the number of places in the queque
+static int GrowQueque( que* p );
+
 // the number of allocated places
 //int s_nPosAlloc;
 // the maximum number of occupied places
@@ -869,9 +1470,9 @@ static que s_Que[3];  // Dist-2, Dist-3, Dist-4 queques
 //            Conditional Adding Cube Pairs To Queques              //
 //////////////////////////////////////////////////////////////////////
 
-int GetPosDiff( int PosBeg, int PosEnd )
+int GetPosDiff( que* p, int PosBeg, int PosEnd )
 {
-	return (PosEnd - PosBeg + s_nPosAlloc) % s_nPosAlloc;
+	return (PosEnd - PosBeg + p->nPosAlloc) % p->nPosAlloc;
 }
 
 void MarkSet()
@@ -910,20 +1511,23 @@ void NewRangeInsertCubePair( cubedist Dist, Cube* p1, Cube* p2 )
 // insert one cube pair into the new range
 {
 	que* p = &s_Que[Dist];
-	int Pos = p->PosCur;
+	int Pos;
+
+	// one place is always kept free, so that the full queque 
+	// could be distinguished from the empty one
+	if ( (p->PosCur+1)%p->nPosAlloc == p->PosOut && !GrowQueque( p ) )
+	{ // the memory budget is exhausted - the pair is lost
+		s_nPosDropped++;
+		return;
+	}
 
-	if ( p->fEmpty || Pos != p->PosOut )
-	{
-		p->pC1[Pos] = p1;
-		p->pC2[Pos] = p2;
-		p->ID1[Pos] = p1->ID;
-		p->ID2[Pos] = p2->ID;
+	Pos = p->PosCur;
+	p->pC1[Pos] = p1;
+	p->pC2[Pos] = p2;
+	p->ID1[Pos] = p1->ID;
+	p->ID2[Pos] = p2->ID;
 
-		p->PosCur = (p->PosCur+1)%s_nPosAlloc;
-	}
-	else
-		assert(0);
-//		cout << endl << "DIST-" << (int)(Dist+2) << ": Have run out of queque space!" << endl;
+	p->PosCur = (p->PosCur+1)%p->nPosAlloc;
 }
 
 void PrintQuequeStats()
@@ -931,9 +1535,9 @@ void PrintQuequeStats()
 /*
 	cout << endl << "Queque statistics: ";
 	cout << " Alloc = " << s_nPosAlloc;
-	cout << "   DIST2 = " << GetPosDiff( s_Que[0].PosOut, s_Que[0].PosIn );
-	cout << "   DIST3 = " << GetPosDiff( s_Que[1].PosOut, s_Que[1].PosIn );
-	cout << "   DIST4 = " << GetPosDiff( s_Que[2].PosOut, s_Que[2].PosIn );
+	cout << "   DIST2 = " << GetPosDiff( &s_Que[0], s_Que[0].PosOut, s_Que[0].PosIn );
+	cout << "   DIST3 = " << GetPosDiff( &s_Que[1], s_Que[1].PosOut, s_Que[1].PosIn );
+	cout << "   DIST4 = " << GetPosDiff( &s_Que[2], s_Que[2].PosOut, s_Que[2].PosIn );
 	cout << endl;
 	cout << endl;
 */
@@ -941,7 +1545,37 @@ void PrintQuequeStats()
 
 int GetQuequeStats( cubedist Dist )
 {
-	return GetPosDiff( s_Que[Dist].PosOut, s_Que[Dist].PosIn );
+	return GetPosDiff( &s_Que[Dist], s_Que[Dist].PosOut, s_Que[Dist].PosIn );
+}
+
+void ShuffleQueques( unsigned Seed )
+// randomly permutes the cube pairs waiting in the queques, so that 
+// the minimization starting from the same cover takes a different path;
+// the pseudo-random numbers do not depend on the C library, 
+// so that the same seed gives the same result on all platforms
+{
+	que* p;
+	Cube* pTemp;
+	unsigned IDTemp;
+	int d, i, k, n, Pos1, Pos2;
+
+	for ( d = 0; d < 3; d++ )
+	{
+		p = &s_Que[d];
+		n = GetPosDiff( p, p->PosOut, p->PosIn );
+		for ( i = n - 1; i > 0; i-- )
+		{
+			Seed = Seed * 1664525 + 1013904223;
+			k = (int)((Seed >> 8) % (unsigned)(i + 1));
+			Pos1 = (p->PosOut + i) % p->nPosAlloc;
+			Pos2 = (p->PosOut + k) % p->nPosAlloc;
+
+			pTemp = p->pC1[Pos1]; p->pC1[Pos1] = p->pC1[Pos2]; p->pC1[Pos2] = pTemp;
+			pTemp = p->pC2[Pos1]; p->pC2[Pos1] = p->pC2[Pos2]; p->pC2[Pos2] = pTemp;
+			IDTemp = p->ID1[Pos1]; p->ID1[Pos1] = p->ID1[Pos2]; p->ID1[Pos2] = IDTemp;
+			IDTemp = p->ID2[Pos1]; p->ID2[Pos1] = p->ID2[Pos2]; p->ID2[Pos2] = IDTemp;
+		}
+	}
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -987,7 +1621,7 @@ int IteratorCubePairStart( cubedist CubeDist, Cube** ppC1, Cube** ppC2 )
 
 	fEntryFound = 0;
 	// go through the entries while there is something in the queque
-	for ( pQ = &s_Que[ CubeDist ]; pQ->PosOut != s_Iter.PosStop; pQ->PosOut = (pQ->PosOut+1)%s_nPosAlloc )
+	for ( pQ = &s_Que[ CubeDist ]; pQ->PosOut != s_Iter.PosStop; pQ->PosOut = (pQ->PosOut+1)%pQ->nPosAlloc )
 	{
 		p1 = pQ->pC1[ pQ->PosOut ];
 		p2 = pQ->pC2[ pQ->PosOut ];
@@ -1007,7 +1641,7 @@ int IteratorCubePairStart( cubedist CubeDist, Cube** ppC1, Cube** ppC2 )
 		*ppC1 = pQ->pC1[ pQ->PosOut ];
 		*ppC2 = pQ->pC2[ pQ->PosOut ];
 
-		pQ->PosOut = (pQ->PosOut+1)%s_nPosAlloc;
+		pQ->PosOut = (pQ->PosOut+1)%pQ->nPosAlloc;
 	}
 	else
 		s_Iter.fStarted = 0;
@@ -1021,7 +1655,7 @@ int IteratorCubePairNext()
 	assert( s_Iter.fStarted );
 
 	// go through the entries while there is something in the queque
-	for ( pQ = &s_Que[ s_Iter.Dist ]; pQ->PosOut != s_Iter.PosStop; pQ->PosOut = (pQ->PosOut+1)%s_nPosAlloc )
+	for ( pQ = &s_Que[ s_Iter.Dist ]; pQ->PosOut != s_Iter.PosStop; pQ->PosOut = (pQ->PosOut+1)%pQ->nPosAlloc )
 	{
 		p1 = pQ->pC1[ pQ->PosOut ];
 		p2 = pQ->pC2[ pQ->PosOut ];
@@ -1041,7 +1675,7 @@ int IteratorCubePairNext()
 		*(s_Iter.ppC1) = pQ->pC1[ pQ->PosOut ];
 		*(s_Iter.ppC2) = pQ->pC2[ pQ->PosOut ];
 
-		pQ->PosOut = (pQ->PosOut+1)%s_nPosAlloc;
+		pQ->PosOut = (pQ->PosOut+1)%pQ->nPosAlloc;
 	}
 	else // iteration has finished
 		s_Iter.fStarted = 0;
@@ -1053,28 +1687,90 @@ int IteratorCubePairNext()
 //                     Allocation/Delocation                        //
 //////////////////////////////////////////////////////////////////////
 
-int AllocateQueques( int nPlaces )
-// nPlaces should be approximately nCubes*nCubes/10
+int AllocateQueques( int nPlaces, int nPlacesMax )
+// nPlaces is the starting number of places in each queque;
+// the queques grow on demand, up to nPlacesMax places each
 // allocates memory for cube pair queques
 {
 	int i;
-	s_nPosAlloc  = nPlaces;
+	if ( nPlacesMax < 2 )
+		nPlacesMax = 2;
+	if ( nPlaces > nPlacesMax )
+		nPlaces = nPlacesMax;
+	s_nPosAlloc   = 3 * nPlaces;
+	s_nPosBudget  = nPlacesMax;
+	s_nPosDropped = 0;
 
 	for ( i = 0; i < 3; i++ )
 	{
 		s_Que[i].pC1 = (Cube**) malloc( nPlaces * sizeof(Cube*) );
 		s_Que[i].pC2 = (Cube**) malloc( nPlaces * sizeof(Cube*) );
-		s_Que[i].ID1 = (byte*) malloc( nPlaces * sizeof(byte) );
-		s_Que[i].ID2 = (byte*) malloc( nPlaces * sizeof(byte) );
+		s_Que[i].ID1 = (unsigned*) malloc( nPlaces * sizeof(unsigned) );
+		s_Que[i].ID2 = (unsigned*) malloc( nPlaces * sizeof(unsigned) );
 
 		if ( s_Que[i].pC1==NULL || s_Que[i].pC2==NULL || s_Que[i].ID1==NULL || s_Que[i].ID2==NULL )
 			return 0;
 
 		s_nPosMax[i] = 0;
 		s_Que[i].fEmpty = 1;
+		s_Que[i].nPosAlloc = nPlaces;
+		s_Que[i].PosOut = s_Que[i].PosIn = s_Que[i].PosCur = s_Que[i].PosMark = 0;
 	}
 
-	return nPlaces * (sizeof(Cube*) + sizeof(Cube*) + 2*sizeof(byte) );
+	return 3 * nPlaces * (sizeof(Cube*) + sizeof(Cube*) + 2*sizeof(unsigned) );
+}
+
+static int GrowQueque( que* p )
+// doubles the number of places in the full queque without losing the pairs;
+// returns 0 if the queque has already reached the memory budget
+{
+	int nPosOld = p->nPosAlloc;
+	int nPosNew = 2 * nPosOld;
+	int Delta, nMove;
+	void * pTemp;
+
+	if ( nPosNew > s_nPosBudget )
+		nPosNew = s_nPosBudget;
+	if ( nPosNew <= nPosOld )
+		return 0;
+
+	pTemp = realloc( p->pC1, nPosNew * sizeof(Cube*) );
+	if ( pTemp == NULL )  return 0;
+	p->pC1 = (Cube**) pTemp;
+	pTemp = realloc( p->pC2, nPosNew * sizeof(Cube*) );
+	if ( pTemp == NULL )  return 0;
+	p->pC2 = (Cube**) pTemp;
+	pTemp = realloc( p->ID1, nPosNew * sizeof(unsigned) );
+	if ( pTemp == NULL )  return 0;
+	p->ID1 = (unsigned*) pTemp;
+	pTemp = realloc( p->ID2, nPosNew * sizeof(unsigned) );
+	if ( pTemp == NULL )  return 0;
+	p->ID2 = (unsigned*) pTemp;
+
+	p->nPosAlloc = nPosNew;
+	s_nPosAlloc += nPosNew - nPosOld;
+
+	// if the occupied places wrap around the end of the old array, 
+	// move the part [PosOut, nPosOld) to the end of the new array;
+	// the positions pointing into this part are moved accordingly
+	if ( p->PosCur < p->PosOut )
+	{
+		Delta = nPosNew - nPosOld;
+		nMove = nPosOld - p->PosOut;
+		memmove( p->pC1 + p->PosOut + Delta, p->pC1 + p->PosOut, nMove * sizeof(Cube*) );
+		memmove( p->pC2 + p->PosOut + Delta, p->pC2 + p->PosOut, nMove * sizeof(Cube*) );
+		memmove( p->ID1 + p->PosOut + Delta, p->ID1 + p->PosOut, nMove * sizeof(unsigned) );
+		memmove( p->ID2 + p->PosOut + Delta, p->ID2 + p->PosOut, nMove * sizeof(unsigned) );
+
+		if ( p->PosIn >= p->PosOut )
+			p->PosIn += Delta;
+		if ( p->PosMark >= p->PosOut )
+			p->PosMark += Delta;
+		if ( s_Iter.fStarted && p == &s_Que[s_Iter.Dist] && s_Iter.PosStop >= p->PosOut )
+			s_Iter.PosStop += Delta;
+		p->PosOut += Delta;
+	}
+	return 1;
 }
 
 void DelocateQueques()
@@ -1089,6 +1785,231 @@ void DelocateQueques()
 	}
 }
 
+///////////////////////////////////////////////////////////////////
+///             PARALLEL EVALUATION OF CUBE PAIRS               ///
+///////////////////////////////////////////////////////////////////
+
+int AllocatePairBatch( int nThreads )
+// allocates memory for the batches of cube pairs evaluated by nThreads threads;
+// returns the number of bytes allocated, or 0 on failure
+{
+	int nWords = g_CoverInfo.nWordsIn + g_CoverInfo.nWordsOut;
+	int i;
+
+	s_nThreads = ( nThreads < PAIR_THREADS_MAX )? nThreads: PAIR_THREADS_MAX;
+
+	s_nPairsAlloc = PAIR_BATCH * s_nThreads;
+	s_pPairC1     = (Cube**) malloc( s_nPairsAlloc * sizeof(Cube*) );
+	s_pPairC2     = (Cube**) malloc( s_nPairsAlloc * sizeof(Cube*) );
+	s_pPairID1    = (unsigned*) malloc( s_nPairsAlloc * sizeof(unsigned) );
+	s_pPairID2    = (unsigned*) malloc( s_nPairsAlloc * sizeof(unsigned) );
+	s_pPairMasks  = (unsigned*) malloc( s_nPairsAlloc * sizeof(unsigned) );
+	// the cubes for each thread and for the main thread checking the pairs again
+	s_pPairCubes  = (Cube*) calloc( 32 * (s_nThreads + 1), sizeof(Cube) );
+	s_pPairData   = (word*) malloc( 32 * (s_nThreads + 1) * nWords * sizeof(word) );
+	if ( s_pPairC1 == NULL || s_pPairC2 == NULL || s_pPairID1 == NULL || s_pPairID2 == NULL || 
+		 s_pPairMasks == NULL || s_pPairCubes == NULL || s_pPairData == NULL )
+		return 0;
+
+	for ( i = 0; i < 32 * (s_nThreads + 1); i++ )
+	{
+		s_pPairCubes[i].pCubeDataIn  = s_pPairData + i * nWords;
+		s_pPairCubes[i].pCubeDataOut = s_pPairData + i * nWords + g_CoverInfo.nWordsIn;
+	}
+	return s_nPairsAlloc * (2*sizeof(Cube*) + 3*sizeof(unsigned)) + 
+		32 * (s_nThreads + 1) * (sizeof(Cube) + nWords * sizeof(word));
+}
+
+void DelocatePairBatch()
+{
+	if ( s_nThreads < 2 )
+		return;
+	free( s_pPairC1 );
+	free( s_pPairC2 );
+	free( s_pPairID1 );
+	free( s_pPairID2 );
+	free( s_pPairMasks );
+	free( s_pPairCubes );
+	free( s_pPairData );
+}
+
+static int PairBatchStart( cubedist Dist, Cube** ppC1, Cube** ppC2 )
+// starts the iterator through the cube pairs of the given distance, which 
+// evaluates the pairs in batches, if there are several threads;
+// the mask of its cubes having close cubes is written into s_PairMask;
+// returns 1 if the first cube pair is found
+{
+	s_PairMask = ~0;
+	if ( s_nThreads < 2 )
+		return IteratorCubePairStart( Dist, ppC1, ppC2 );
+
+	s_ppPairC1 = ppC1;
+	s_ppPairC2 = ppC2;
+	s_nPairs = s_iPair = 0;
+	s_fPairsLeft = 1;
+	s_fPairsStarted = 0;
+	return PairBatchNext();
+}
+
+static int PairBatchNext()
+// gives the next cube pair, which has not been changed by the previous pairs
+{
+	Cube *p1, *p2;
+	int i;
+
+	if ( s_nThreads < 2 )
+		return IteratorCubePairNext();
+
+	while ( 1 )
+	{
+		if ( s_iPair == s_nPairs && !PairBatchFill() )
+			return 0;
+		i = s_iPair++;
+		p1 = s_pPairC1[i];
+		p2 = s_pPairC2[i];
+		// skip the pair if one of the cubes has been changed since the pair was taken
+		if ( p1->ID != s_pPairID1[i] || p2->ID != s_pPairID2[i] )
+			continue;
+
+		// check the cubes that appeared in the list after the pair was evaluated
+		s_PairMask = s_pPairMasks[i];
+		if ( s_nPairRemoved != s_nActsRemoved )
+			s_PairMask = ~0;
+		else if ( s_nPairActs < s_nActs && s_PairMask != ~0 )
+			s_PairMask |= PairEvaluate( s_pPairCubes + 32 * s_nThreads, p1, p2, s_nPairActs );
+		*s_ppPairC1 = p1;
+		*s_ppPairC2 = p2;
+		return 1;
+	}
+}
+
+static int PairBatchFill()
+// takes the next batch of pairs from the queque and evaluates them in parallel;
+// returns 0 if there are no more pairs
+{
+	pthread_t Threads[PAIR_THREADS_MAX];
+	int fStarted[PAIR_THREADS_MAX];
+	int t;
+
+	// take the pairs from the queque
+	// (their IDs are recorded right away, because the pairs are valid at this moment)
+	for ( s_nPairs = s_iPair = 0; s_fPairsLeft && s_nPairs < s_nPairsAlloc; s_nPairs++ )
+	{
+		if ( s_fPairsStarted )
+			s_fPairsLeft = IteratorCubePairNext();
+		else
+			s_fPairsLeft = IteratorCubePairStart( s_Dist, &s_pPairNext1, &s_pPairNext2 );
+		s_fPairsStarted = 1;
+		if ( !s_fPairsLeft )
+			break;
+		s_pPairC1[s_nPairs]  = s_pPairNext1;
+		s_pPairC2[s_nPairs]  = s_pPairNext2;
+		s_pPairID1[s_nPairs] = s_pPairNext1->ID;
+		s_pPairID2[s_nPairs] = s_pPairNext2->ID;
+	}
+	if ( s_nPairs == 0 )
+		return 0;
+
+	// remember the state of the dense arrays
+	s_nPairActs = s_nActs;
+	s_nPairRemoved = s_nActsRemoved;
+
+	// evaluate the pairs; the main thread is thread 0
+	// (the pairs of the threads that could not be started are evaluated by it, too)
+	for ( t = 1; t < s_nThreads; t++ )
+		fStarted[t] = !pthread_create( Threads + t, NULL, PairBatchThread, (void*)(size_t)t );
+	PairBatchThread( (void*)0 );
+	for ( t = 1; t < s_nThreads; t++ )
+		if ( fStarted[t] )
+			pthread_join( Threads[t], NULL );
+		else
+			PairBatchThread( (void*)(size_t)t );
+	return 1;
+}
+
+static void* PairBatchThread( void* pArg )
+// evaluates the pairs of the batch given to this thread;
+// the code reached from here must not write any file-static variables
+// (in "exorBits.c", GetDistance() and GetDistancePlus() use such variables
+// and are not called by the threads)
+{
+	int t = (int)(size_t)pArg;
+	int i;
+	for ( i = t; i < s_nPairs; i += s_nThreads )
+		s_pPairMasks[i] = PairEvaluate( s_pPairCubes + 32 * t, s_pPairC1[i], s_pPairC2[i], 0 );
+	return NULL;
+}
+
+static unsigned PairEvaluate( Cube* pCubes, Cube* pC1, Cube* pC2, int iBeg )
+// generates the ExorLinked cubes of the pair into pCubes[] and checks which
+// of them have close cubes at the positions starting from iBeg;
+// returns the mask of these cubes (all ones if the pair has wrong distance)
+{
+	unsigned Mask = 0;
+	int nCubes, c;
+
+	nCubes = ExorLinkCubesGenerate( pCubes, pC1, pC2, s_Dist );
+	if ( nCubes == 0 )
+		return ~0;
+	for ( c = 0; c < nCubes; c++ )
+		if ( PairCubeIsClose( pCubes + c, pC1, pC2, iBeg ) )
+			Mask |= ((unsigned)1 << c);
+	return Mask;
+}
+
+static int PairCubeIsClose( Cube* p, Cube* pC1, Cube* pC2, int iBeg )
+// returns 1 if there is a cube in the list at the position iBeg or later, 
+// other than pC1 and pC2, which is dist-0 or dist-1 removed from p;
+// such a cube falls into the same bins as p in all groups but one, so it is
+// enough to look at one of the two bins, which are the smallest for p;
+// the index is only read here, so that the threads can use it at once
+{
+	int nWordsIn  = g_CoverInfo.nWordsIn;
+	int nWordsOut = g_CoverInfo.nWordsOut;
+	int Groups[2], Bins[2], Sizes[2], Bin, g, k, i;
+	Cube* q;
+
+	// find the two smallest bins
+	Sizes[0] = Sizes[1] = s_nActs;
+	for ( g = 0; g < s_nGroups; g++ )
+	{
+		Bin = GroupHash( p, g ) & (s_nBins-1);
+		if ( s_pBinSizes[g][Bin] < Sizes[0] )
+		{
+			Groups[1] = Groups[0];  Bins[1] = Bins[0];  Sizes[1] = Sizes[0];
+			Groups[0] = g;          Bins[0] = Bin;      Sizes[0] = s_pBinSizes[g][Bin];
+		}
+		else if ( s_pBinSizes[g][Bin] < Sizes[1] )
+		{
+			Groups[1] = g;          Bins[1] = Bin;      Sizes[1] = s_pBinSizes[g][Bin];
+		}
+	}
+
+	if ( s_nGroups < 2 || Sizes[0] + Sizes[1] >= (s_nActs - iBeg) / 4 )
+	{ // look at all cubes starting from iBeg
+		for ( i = s_nActs - iBeg; (i = ScanCloseCubes( p, 1, s_pActIn + iBeg * nWordsIn, 
+			s_pActOut + iBeg * nWordsOut, s_pActLits + iBeg, i )) >= 0; )
+			if ( s_pActCubes[iBeg + i] != pC1 && s_pActCubes[iBeg + i] != pC2 )
+				return 1;
+		return 0;
+	}
+
+	// look at the cubes in the two bins
+	for ( k = 0; k < 2; k++ )
+	{
+		g = Groups[k];
+		for ( q = s_pBins[g][Bins[k]]; q; q = q->pIdx->NextH[g] )
+		{
+			if ( q == pC1 || q == pC2 || q->Pos < iBeg )
+				continue;
+			if ( ScanCloseCubes( p, 1, s_pActIn + q->Pos * nWordsIn, 
+				s_pActOut + q->Pos * nWordsOut, s_pActLits + q->Pos, 1 ) == 0 )
+				return 1;
+		}
+	}
+	return 0;
+}
+
 ///////////////////////////////////////////////////////////////////
 ////////////              End of File             /////////////////
 ///////////////////////////////////////////////////////////////////
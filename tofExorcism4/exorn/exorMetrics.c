@@ -0,0 +1,147 @@
+////////////////////////////////////////////////////////////////////////
+///                                                                  ///
+///                  Implementation of EXORCISM - 4                  ///
+///              An Exclusive Sum-of-Product Minimizer               ///
+///               Alan Mishchenko  <alanmi@ee.pdx.edu>               ///
+///                                                                  ///
+////////////////////////////////////////////////////////////////////////
+///                                                                  ///
+///                          Metrics Module                          ///
+///                                                                  ///
+///      1) the gate counts, quantum cost, lines and depth           ///
+///         collected while the cascade is written                   ///
+///      2) writing the metrics into the sidecar file                ///
+///                                                                  ///
+////////////////////////////////////////////////////////////////////////
+///   This software was tested with the BDD package "CUDD", v.2.3.0  ///
+///                          by Fabio Somenzi                        ///
+///                  http://vlsi.colorado.edu/~fabio/                ///
+////////////////////////////////////////////////////////////////////////
+
+#include "exor.h"
+#include "extra.h"
+#include <string.h>
+
+////////////////////////////////////////////////////////////////////////
+///                       EXTERNAL FUNCTIONS                         ///
+////////////////////////////////////////////////////////////////////////
+
+// the quantum cost of one gate
+extern double CascadeGateCost( int nControls );
+
+////////////////////////////////////////////////////////////////////////
+///                    FUNCTIONS OF THIS MODULE                      ///
+////////////////////////////////////////////////////////////////////////
+
+// starts collecting the metrics of the cascade
+int  MetricsStart( tmetrics * p, tcascade * pCas );
+// adds the gate to the metrics
+void MetricsAddGate( tmetrics * p, tcascade * pCas, int g );
+// finishes collecting the metrics
+void MetricsStop( tmetrics * p );
+// writes the metrics into the file
+int  MetricsWriteFile( tmetrics * p, tstats * pStats, char * pFileName );
+
+////////////////////////////////////////////////////////////////////////
+///                        STATIC VARIABLES                          ///
+////////////////////////////////////////////////////////////////////////
+
+// the level of the last gate acting on each line
+static int * s_pLevels = NULL;
+
+////////////////////////////////////////////////////////////////////////
+///                      FUNCTION DEFINITIONS                        ///
+////////////////////////////////////////////////////////////////////////
+
+int MetricsStart( tmetrics * p, tcascade * pCas )
+// returns 0 if memory cannot be allocated
+{
+	memset( p, 0, sizeof(tmetrics) );
+	p->nLines   = pCas->nLines;
+	p->nLinesIn = pCas->nLinesIn;
+	FREE( s_pLevels );
+	s_pLevels = ALLOC( int, pCas->nLines );
+	if ( s_pLevels == NULL )
+		return 0;
+	memset( s_pLevels, 0, sizeof(int) * pCas->nLines );
+	return 1;
+}
+
+void MetricsAddGate( tmetrics * p, tcascade * pCas, int g )
+// the gate is placed one level after the last gate acting on any of its
+// lines (the gates acting on disjoint lines are applied in parallel)
+{
+	word * pControls, Word;
+	int w, Line, Level, Size;
+
+	// find the level of the gate
+	Level = s_pLevels[pCas->pTargets[g]];
+	pControls = CascadeControls( pCas, g );
+	for ( w = 0; w < pCas->nWords; w++ )
+		for ( Word = pControls[w], Line = w * BPI; Word; Word >>= 1, Line++ )
+			if ( (Word & 1) && Level < s_pLevels[Line] )
+				Level = s_pLevels[Line];
+	Level++;
+	// assign the level to the lines of the gate
+	s_pLevels[pCas->pTargets[g]] = Level;
+	for ( w = 0; w < pCas->nWords; w++ )
+		for ( Word = pControls[w], Line = w * BPI; Word; Word >>= 1, Line++ )
+			if ( Word & 1 )
+				s_pLevels[Line] = Level;
+	if ( p->Depth < Level )
+		p->Depth = Level;
+
+	// count the gate
+	Size = pCas->pnControls[g] + 1;
+	p->nSizes[ (Size < METRICS_SIZES)? Size: METRICS_SIZES ]++;
+	p->nNots += ( pCas->pTargets[g] < pCas->nLinesIn );
+	p->nGates++;
+	p->qCost += CascadeGateCost( pCas->pnControls[g] );
+}
+
+void MetricsStop( tmetrics * p )
+{
+	FREE( s_pLevels );
+}
+
+int MetricsWriteFile( tmetrics * p, tstats * pStats, char * pFileName )
+// writes the metrics and the statistics as one JSON object;
+// returns 0 if the file cannot be opened
+{
+	FILE * pFile;
+	int i;
+
+	pFile = fopen( pFileName, "w" );
+	if ( pFile == NULL )
+		return 0;
+	fprintf( pFile, "{\n" );
+	fprintf( pFile, "  \"in\": %d,\n", pStats->nVarsIn );
+	fprintf( pFile, "  \"out\": %d,\n", pStats->nVarsOut );
+	fprintf( pFile, "  \"cubes\": %d,\n", pStats->nCubes );
+	fprintf( pFile, "  \"lines\": %d,\n", p->nLines );
+	fprintf( pFile, "  \"inputLines\": %d,\n", p->nLinesIn );
+	fprintf( pFile, "  \"gates\": %ld,\n", p->nGates - p->nNots );
+	fprintf( pFile, "  \"nots\": %ld,\n", p->nNots );
+	fprintf( pFile, "  \"quantumCost\": %.0f,\n", p->qCost );
+	fprintf( pFile, "  \"depth\": %d,\n", p->Depth );
+	fprintf( pFile, "  \"gatesBySize\": {" );
+	for ( i = 1; i <= METRICS_SIZES; i++ )
+		fprintf( pFile, "%s\"%s%d\": %ld", (i > 1)? ", ": "", (i == METRICS_SIZES)? "T>=": "T", i, p->nSizes[i] );
+	fprintf( pFile, "},\n" );
+	fprintf( pFile, "  \"gatesBefore\": %ld,\n", pStats->nGatesBefore );
+	fprintf( pFile, "  \"notsBefore\": %ld,\n", pStats->nNotsBefore );
+	fprintf( pFile, "  \"quantumCostBefore\": %.0f,\n", pStats->qCostBefore );
+	fprintf( pFile, "  \"esopTime\": %.2f,\n", pStats->esopTime );
+	fprintf( pFile, "  \"reorderTime\": %.2f,\n", pStats->reorderTime );
+	fprintf( pFile, "  \"notRemovalTime\": %.2f,\n", pStats->notRemovalTime );
+	fprintf( pFile, "  \"peepholeTime\": %.2f,\n", pStats->peepholeTime );
+	fprintf( pFile, "  \"toffoliTime\": %.2f,\n", pStats->toffoliTime );
+	fprintf( pFile, "  \"totalTime\": %.2f\n", pStats->totalTime );
+	fprintf( pFile, "}\n" );
+	fclose( pFile );
+	return 1;
+}
+
+///////////////////////////////////////////////////////////////////
+////////////              End of File             /////////////////
+///////////////////////////////////////////////////////////////////
@@ -0,0 +1,380 @@
+////////////////////////////////////////////////////////////////////////
+///                                                                  ///
+///                  Implementation of EXORCISM - 4                  ///
+///              An Exclusive Sum-of-Product Minimizer               ///
+///               Alan Mishchenko  <alanmi@ee.pdx.edu>               ///
+///                                                                  ///
+////////////////////////////////////////////////////////////////////////
+///                                                                  ///
+///                    Output Equivalence Classes                    ///
+///                                                                  ///
+///      1) grouping the outputs equal up to input/output negation   ///
+///      2) deriving the cubes of the outputs from the minimized     ///
+///         cubes of the representatives of their classes           ///
+///                                                                  ///
+////////////////////////////////////////////////////////////////////////
+///   This software was tested with the BDD package "CUDD", v.2.3.0  ///
+///                          by Fabio Somenzi                        ///
+///                  http://vlsi.colorado.edu/~fabio/                ///
+////////////////////////////////////////////////////////////////////////
+
+#include "exor.h"
+#include "extra.h"
+#include <string.h>
+#include <math.h>
+
+////////////////////////////////////////////////////////////////////////
+///                       EXTERNAL VARIABLES                         ///
+////////////////////////////////////////////////////////////////////////
+
+// information about the options and the cover
+extern cinfo g_CoverInfo;
+
+// the cover access procedures
+extern Cube* IterCubeSetStart();
+extern Cube* IterCubeSetNext();
+extern void CubeInsert( Cube* p );
+extern Cube* CubeExtract( Cube* p );
+extern Cube* GetFreeCube();
+extern void AddToFreeCubes( Cube* p );
+
+////////////////////////////////////////////////////////////////////////
+///                    FUNCTIONS OF THIS MODULE                      ///
+////////////////////////////////////////////////////////////////////////
+
+// groups the outputs into classes and selects the functions to be minimized
+int  NpnClassifyOutputs( DdManager * dd, DdNode ** pOutputs, int nOutputs, int nInputs, DdNode ** pReprs );
+// adds the cubes of the outputs that are not representatives
+int NpnExpandCover();
+
+// computes the canonical form of the output
+static DdNode * NpnCanonicalForm( DdManager * dd, DdNode * bFunc, word * pMask, int * pPhase );
+// applies the negation of the variables in the mask to the cube
+static void NpnFlipCube( word * pDataIn, word * pMask );
+static int  NpnMaskIsEmpty( word * pMask );
+
+////////////////////////////////////////////////////////////////////////
+///                        STATIC VARIABLES                          ///
+////////////////////////////////////////////////////////////////////////
+
+// the representative of the class of each output (the output itself for
+// the representative) and the transformation deriving the output from it:
+// the inputs negated (two bits of the variable in the mask of the output)
+// and the output negated (s_pPhase)
+static int  * s_pRepr  = NULL;
+static int  * s_pPhase = NULL;
+static word * s_pMasks = NULL;
+static int    s_nOutputs = 0;
+
+////////////////////////////////////////////////////////////////////////
+///                      FUNCTION DEFINITIONS                        ///
+////////////////////////////////////////////////////////////////////////
+
+int NpnClassifyOutputs( DdManager * dd, DdNode ** pOutputs, int nOutputs, int nInputs, DdNode ** pReprs )
+// groups the outputs into the classes of functions equal up to the negation
+// of the inputs and the output; the canonical forms are computed only for
+// the outputs having the same support and the same minterm count (up to
+// the output negation) as some other output; the representatives are
+// returned in pReprs, the other outputs are replaced by constant 0, so that
+// their cubes are not generated and minimized; returns the number of classes,
+// or -1 if memory cannot be allocated
+{
+	int nWords = g_CoverInfo.nWordsIn;
+	DdNode ** pSupps, ** pKeys;
+	double * pMints, Total = pow( 2.0, (double)nInputs );
+	int fReorder, nClasses = 0, o, r, w;
+	Cudd_ReorderingType Method;
+
+	s_nOutputs = nOutputs;
+	s_pRepr  = ALLOC( int, nOutputs );
+	s_pPhase = ALLOC( int, nOutputs );
+	s_pMasks = ALLOC( word, nOutputs * nWords );
+	pSupps = ALLOC( DdNode *, nOutputs );
+	pKeys  = ALLOC( DdNode *, nOutputs );
+	pMints = ALLOC( double, nOutputs );
+	if ( s_pRepr == NULL || s_pPhase == NULL || s_pMasks == NULL || pSupps == NULL || pKeys == NULL || pMints == NULL )
+	{
+		FREE( s_pRepr );
+		FREE( s_pPhase );
+		FREE( s_pMasks );
+		FREE( pSupps );
+		FREE( pKeys );
+		FREE( pMints );
+		return -1;
+	}
+	memset( s_pMasks, 0, sizeof(word) * nOutputs * nWords );
+
+	// the canonical forms depend on the variable order
+	fReorder = Cudd_ReorderingStatus( dd, &Method );
+	Cudd_AutodynDisable( dd );
+
+	// the invariants of the negations: the support and the minterm count
+	for ( o = 0; o < nOutputs; o++ )
+	{
+		pSupps[o] = Cudd_Support( dd, pOutputs[o] );  Cudd_Ref( pSupps[o] );
+		pMints[o] = Cudd_CountMinterm( dd, pOutputs[o], nInputs );
+		if ( pMints[o] > Total - pMints[o] )
+			pMints[o] = Total - pMints[o];
+		pKeys[o] = NULL;
+		s_pRepr[o] = o;
+		s_pPhase[o] = 0;
+	}
+
+	for ( o = 0; o < nOutputs; o++ )
+	{
+		// skip the output if no other output has the same invariants
+		for ( r = 0; r < nOutputs; r++ )
+			if ( r != o && pSupps[r] == pSupps[o] && pMints[r] == pMints[o] )
+				break;
+		if ( r == nOutputs )
+		{
+			pReprs[o] = pOutputs[o];
+			nClasses++;
+			continue;
+		}
+		pKeys[o] = NpnCanonicalForm( dd, pOutputs[o], s_pMasks + o * nWords, s_pPhase + o );
+		// find the representative with the same canonical form
+		for ( r = 0; r < o; r++ )
+			if ( s_pRepr[r] == r && pKeys[r] == pKeys[o] )
+				break;
+		if ( r == o )
+		{
+			pReprs[o] = pOutputs[o];
+			nClasses++;
+			continue;
+		}
+		// the output is derived from the representative
+		s_pRepr[o] = r;
+		s_pPhase[o] ^= s_pPhase[r];
+		for ( w = 0; w < nWords; w++ )
+			s_pMasks[o * nWords + w] ^= s_pMasks[r * nWords + w];
+		pReprs[o] = Cudd_Not( Cudd_ReadOne( dd ) );
+	}
+
+	for ( o = 0; o < nOutputs; o++ )
+	{
+		Cudd_RecursiveDeref( dd, pSupps[o] );
+		if ( pKeys[o] )
+			Cudd_RecursiveDeref( dd, pKeys[o] );
+	}
+	if ( fReorder )
+		Cudd_AutodynEnable( dd, Method );
+	FREE( pSupps );
+	FREE( pKeys );
+	FREE( pMints );
+
+	if ( g_CoverInfo.Verbosity )
+	printf( "The outputs fall into %d classes up to input/output negation\n", nClasses );
+	return nClasses;
+}
+
+static DdNode * NpnCanonicalForm( DdManager * dd, DdNode * bFunc, word * pMask, int * pPhase )
+// returns the referenced canonical form of the function up to the negation
+// of the inputs and the output: the N-canonical form of the function or of
+// its complement, whichever has the smaller truth vector; the function is
+// derived from the canonical form by negating the inputs in the mask
+// and by negating the output if the phase is 1
+{
+	DdNode * bKey0, * bKey1, * bPol0, * bPol1, * bPol, * bCube;
+	int v;
+
+	bKey0 = Extra_bddNCanonicalForm( dd, bFunc, &bPol0 );            Cudd_Ref( bKey0 );  Cudd_Ref( bPol0 );
+	bKey1 = Extra_bddNCanonicalForm( dd, Cudd_Not(bFunc), &bPol1 );  Cudd_Ref( bKey1 );  Cudd_Ref( bPol1 );
+	*pPhase = ( Extra_bddCompareTruthVectors( dd, bKey1, bKey0 ) == 1 );
+	if ( *pPhase )
+	{
+		Cudd_RecursiveDeref( dd, bKey0 );
+		Cudd_RecursiveDeref( dd, bPol0 );
+		bKey0 = bKey1;
+		bPol  = bPol1;
+	}
+	else
+	{
+		Cudd_RecursiveDeref( dd, bKey1 );
+		Cudd_RecursiveDeref( dd, bPol1 );
+		bPol  = bPol0;
+	}
+	// the polarity is the cube of the negated variables
+	for ( bCube = bPol; bCube != Cudd_ReadOne( dd ); bCube = cuddT(bCube) )
+	{
+		v = Cudd_Regular(bCube)->index;
+		pMask[VarWord(v<<1)] |= ((word)VAR_ABS) << VarBit(v<<1);
+	}
+	Cudd_RecursiveDeref( dd, bPol );
+	return bKey0;
+}
+
+int NpnExpandCover()
+// adds the output bits of the outputs that are not representatives: if the output
+// is derived from its representative without negating the inputs, the bit is added
+// to the cubes of the representative; otherwise, the cubes with the negated literals
+// are added (shared by the outputs with the same negated inputs); the negated outputs
+// toggle their bits in the cube without literals; also frees the classes;
+// returns 0 if memory cannot be allocated
+{
+	int nWords = g_CoverInfo.nWordsIn;
+	Cube ** pCubes, ** pTargets, * p, * pNew, * pTaut;
+	word * pToggle;
+	int nCubes, c, o, o2, w, fToggle, RetValue = 1;
+
+	if ( s_pRepr == NULL || s_pPhase == NULL || s_pMasks == NULL )
+		goto finish;
+
+	// collect the cubes, because the cubes are added to the list
+	nCubes = g_CoverInfo.nCubesInUse;
+	pCubes = ALLOC( Cube *, nCubes + 1 );
+	pTargets = ALLOC( Cube *, s_nOutputs );
+	pToggle = ALLOC( word, g_CoverInfo.nWordsOut );
+	if ( pCubes == NULL || pTargets == NULL || pToggle == NULL )
+	{
+		printf( "\nUnexpected memory allocation problem. Quitting...\n" );
+		FREE( pCubes );
+		FREE( pTargets );
+		FREE( pToggle );
+		RetValue = 0;
+		goto finish;
+	}
+	c = 0;
+	for ( p = IterCubeSetStart( ); p; p = IterCubeSetNext() )
+		pCubes[c++] = p;
+	assert( c == nCubes );
+
+	for ( c = 0; c < nCubes; c++ )
+	{
+		p = pCubes[c];
+		for ( o = 0; o < s_nOutputs; o++ )
+		{
+			pTargets[o] = NULL;
+			if ( s_pRepr[o] == o || !(p->pCubeDataOut[s_pRepr[o]/BPI] & (((word)1) << (s_pRepr[o]%BPI))) )
+				continue;
+			// the cube derived for another output with the same negated inputs
+			for ( o2 = 0; o2 < o; o2++ )
+				if ( pTargets[o2] && s_pRepr[o2] == s_pRepr[o] &&
+					!memcmp( s_pMasks + o2 * nWords, s_pMasks + o * nWords, sizeof(word) * nWords ) )
+					break;
+			if ( o2 < o )
+				pTargets[o] = pTargets[o2];
+			else if ( NpnMaskIsEmpty( s_pMasks + o * nWords ) )
+				pTargets[o] = p;
+			else
+			{
+				pNew = GetFreeCube();
+				memcpy( pNew->pCubeDataIn, p->pCubeDataIn, sizeof(word) * nWords );
+				memset( pNew->pCubeDataOut, 0, sizeof(word) * g_CoverInfo.nWordsOut );
+				NpnFlipCube( pNew->pCubeDataIn, s_pMasks + o * nWords );
+				pNew->a = p->a;
+				pNew->z = 0;
+				pNew->fMark = 0;
+				pNew->ID = 0;
+				pTargets[o] = pNew;
+			}
+			pTargets[o]->pCubeDataOut[o/BPI] |= ((word)1) << (o%BPI);
+			pTargets[o]->z++;
+		}
+		// insert the new cubes (the cube extracted if its output bits changed)
+		for ( o = 0; o < s_nOutputs; o++ )
+		{
+			if ( pTargets[o] == NULL || pTargets[o]->ID )
+				continue;
+			for ( o2 = o + 1; o2 < s_nOutputs; o2++ )
+				if ( pTargets[o2] == pTargets[o] )
+					pTargets[o2] = NULL;
+			pTargets[o]->ID = g_CoverInfo.cIDs++;
+			if ( g_CoverInfo.cIDs == 0 )
+				g_CoverInfo.cIDs = 1;
+			CubeInsert( pTargets[o] );
+		}
+		for ( o = 0; o < s_nOutputs; o++ )
+			if ( pTargets[o] == p )
+			{
+				// the cube is reinserted to update the output bits in the list
+				CubeExtract( p );
+				CubeInsert( p );
+				break;
+			}
+	}
+
+	// toggle the negated outputs in the cube without literals
+	memset( pToggle, 0, sizeof(word) * g_CoverInfo.nWordsOut );
+	fToggle = 0;
+	for ( o = 0; o < s_nOutputs; o++ )
+		if ( s_pRepr[o] != o && s_pPhase[o] )
+		{
+			pToggle[o/BPI] |= ((word)1) << (o%BPI);
+			fToggle = 1;
+		}
+	if ( fToggle )
+	{
+		for ( pTaut = IterCubeSetStart( ); pTaut; pTaut = IterCubeSetNext() )
+			if ( pTaut->a == 0 )
+				break;
+		if ( pTaut )
+		{
+			// finish the iterator before the cube is extracted
+			while ( IterCubeSetNext() );
+			CubeExtract( pTaut );
+		}
+		else
+		{
+			pTaut = GetFreeCube();
+			for ( w = 0; w < nWords; w++ )
+				pTaut->pCubeDataIn[w] = 0;
+			for ( o = 0; o < g_CoverInfo.nVarsIn; o++ )
+				pTaut->pCubeDataIn[VarWord(o<<1)] |= ((word)VAR_ABS) << VarBit(o<<1);
+			memset( pTaut->pCubeDataOut, 0, sizeof(word) * g_CoverInfo.nWordsOut );
+			pTaut->a = 0;
+			pTaut->fMark = 0;
+			pTaut->ID = g_CoverInfo.cIDs++;
+			if ( g_CoverInfo.cIDs == 0 )
+				g_CoverInfo.cIDs = 1;
+		}
+		for ( w = 0; w < g_CoverInfo.nWordsOut; w++ )
+			pTaut->pCubeDataOut[w] ^= pToggle[w];
+		// count the outputs of the cube
+		pTaut->z = 0;
+		for ( o = 0; o < g_CoverInfo.nVarsOut; o++ )
+			pTaut->z += ( (pTaut->pCubeDataOut[o/BPI] & (((word)1) << (o%BPI))) != 0 );
+		if ( pTaut->z )
+			CubeInsert( pTaut );
+		else
+			AddToFreeCubes( pTaut );
+	}
+	FREE( pCubes );
+	FREE( pTargets );
+	FREE( pToggle );
+
+finish:
+	FREE( s_pRepr );
+	FREE( s_pPhase );
+	FREE( s_pMasks );
+	s_nOutputs = 0;
+	return RetValue;
+}
+
+static void NpnFlipCube( word * pDataIn, word * pMask )
+// swaps the literals 0 and 1 of the variables in the mask
+// (the variables without the literal, '-' = 11, are not changed)
+{
+	word Lits, Odd;
+	int w;
+	for ( w = 0; w < g_CoverInfo.nWordsIn; w++ )
+	{
+		Lits = pDataIn[w] & pMask[w];
+		// the lower bit of the variables having exactly one of the two bits
+		Odd = (Lits ^ (Lits >> 1)) & pMask[w] & (word)0x5555555555555555ULL;
+		pDataIn[w] ^= Odd | (Odd << 1);
+	}
+}
+
+static int NpnMaskIsEmpty( word * pMask )
+{
+	int w;
+	for ( w = 0; w < g_CoverInfo.nWordsIn; w++ )
+		if ( pMask[w] )
+			return 0;
+	return 1;
+}
+
+///////////////////////////////////////////////////////////////////
+////////////              End of File             /////////////////
+///////////////////////////////////////////////////////////////////
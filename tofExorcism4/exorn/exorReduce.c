@@ -30,6 +30,10 @@
 
 #include "exor.h"
 #include "extra.h"
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
 
 ////////////////////////////////////////////////////////////////////////
 ///                       EXTERNAL VARIABLES                         ///
@@ -46,6 +50,8 @@ extern int s_fDecreaseLiterals;
 extern int s_nPosAlloc;
 // the peak number of occupied places in the adjacency queques
 extern int s_nPosMax[3];
+// the number of cube pairs not enquequed because of the memory budget
+extern int s_nPosDropped;
 
 ////////////////////////////////////////////////////////////////////////
 ///                      EXTERNAL FUNCTIONS                          ///
@@ -55,14 +61,21 @@ extern int s_nPosMax[3];
 extern int AllocateCover( int nCubes, int nWordsIn, int nWordsOut );
 extern void DelocateCover();
 
+// selection of the cube distance kernels for the given cube size
+extern void SelectDistanceKernels( int nWordsIn );
+
 // cube storage allocation/delocation
 extern int AllocateCubeSets( int nVarsIn, int nVarsOut );
 extern void DelocateCubeSets();
 
 // adjacency queque allocation/delocation procedures
-extern int AllocateQueques( int nPlaces );
+extern int AllocateQueques( int nPlaces, int nPlacesMax );
 extern void DelocateQueques();
 
+// the batches of cube pairs evaluated in parallel
+extern int AllocatePairBatch( int nThreads );
+extern void DelocatePairBatch();
+
 // Pseudo-Kronecker cover computation
 extern int  CountTermsInPseudoKroneckerCover( DdManager *bddm, DdNode** OnSets );
 extern void GeneratePseudoKroneckerCover();
@@ -76,6 +89,27 @@ extern int IterativelyApplyExorLink4( char fDistEnable );
 // imported file writing procedures
 extern int WriteResultIntoFile();
 
+// the strategies of the portfolio runs
+extern void ShuffleQueques( unsigned Seed );
+extern void ExorLinkSetGroupOrder( int fMinLitFirst );
+
+// the cover access procedures
+extern Cube* IterCubeSetStart();
+extern Cube* IterCubeSetNext();
+extern void CubeInsert( Cube* p );
+extern Cube* CubeExtract( Cube* p );
+extern Cube* GetFreeCube();
+extern void AddToFreeCubes( Cube* p );
+extern int CountLiterals();
+
+// the records of the cubes sent through the pipes
+extern int   CubeRecordSize();
+extern char* CubeRecordWrite( char* pRecord, int nLits, int nOuts, word* pIn, word* pOut );
+extern char* CubeRecordRead( char* pRecord, Cube* p );
+
+// the wall-clock time
+extern double GetWallTime();
+
 // cover/cube printing
 /*
 extern void PrintCube( ostream& DebugStream, Cube* pC );
@@ -88,6 +122,15 @@ extern int GetQuequeStats( cubedist Dist );
 extern int GetNumberOfCubes( DdManager * dd, DdNode ** pbFuncs, int nFuncs );
 extern void AddCubesToStartingCover( DdManager * dd );
 
+// the cache of the minimized covers
+extern int   CacheComputeKey( DdManager * dd, DdNode ** pOutputs, int nInputs, int nOutputs, char * pKey );
+extern char* CacheRead( char * pDir, char * pKey, int * pnCubes, int * pnLits );
+extern int   CacheWrite( char * pDir, char * pKey );
+
+// the classes of the outputs equal up to input/output negation
+extern int  NpnClassifyOutputs( DdManager * dd, DdNode ** pOutputs, int nOutputs, int nInputs, DdNode ** pReprs );
+extern int  NpnExpandCover();
+
 
 ////////////////////////////////////////////////////////////////////////
 ///                    FUNCTIONS OF THIS MODULE                      ///
@@ -99,10 +142,36 @@ int Exorcism();
 // iterative reduction of the cover
 int ReduceEsopCover();
 
+// one round of ExorLink followed by the progress checkpoint
+static int ReduceExorLink( int Dist, char fDistEnable );
+
+// the portfolio of reductions starting from the same cover
+static int ReduceEsopCoverPortfolio();
+// sets the strategy of the portfolio run
+static void PortfolioSetStrategy( int Run );
+// sends/receives the cover through the pipe
+static int PortfolioSendCover( int fd );
+static char* PortfolioReceiveCover( int fd, int* pnCubes, int* pnLits );
+// replaces the current cover by the received one
+static void PortfolioInstallCover( char* pBuffer, int nCubes );
+// reads/writes the given number of bytes through the pipe
+static int PortfolioTransfer( int fd, char* pBuffer, int nBytes, int fWrite );
+
+// minimizes the clusters of outputs with disjoint supports in parallel
+static int ReduceEsopCoverClusters();
+// groups the outputs into the clusters with disjoint supports
+static int ClusterOutputs( DdManager * dd, DdNode ** pOutputs, int nOutputs, int * pClusters );
+static int ClusterFind( int * pParents, int Out );
+// receives the cover of the cluster and waits for its process
+static char* ClusterCollect( int fd, int Pid, int* pnCubes );
+
 ////////////////////////////////////////////////////////////////////////
 ///                        STATIC VARIABLES                          ///
 ////////////////////////////////////////////////////////////////////////
 
+// the number of ExorLink rounds performed by ReduceEsopCover()
+static int s_nRounds = 0;
+
 ////////////////////////////////////////////////////////////////////////
 ///                      FUNCTION DEFINITIONS                        ///
 ////////////////////////////////////////////////////////////////////////
@@ -116,9 +185,11 @@ int Exorcism()
 	int RemainderBits;
 	int TotalWords;
 	int MemTemp, MemTotal;
-	BFunc Func2;
-	int fVerificationOkay;
 	int i;
+	char CacheKey[200], * pCached = NULL;
+	int nCached, nCachedLits;
+	int fWritten;
+	DdNode ** pReprs;
 
 	///////////////////////////////////////////////////////////////////////
 	// STEPS of HEURISTIC ESOP MINIMIZATION
@@ -128,35 +199,60 @@ int Exorcism()
 	///////////////////////////////////////////////////////////////////////
 	assert( g_Func.nInputs > 0 );
 	// inputs
-	RemainderBits = (g_Func.nInputs*2)%(sizeof(unsigned)*8);
-	TotalWords    = (g_Func.nInputs*2)/(sizeof(unsigned)*8) + (RemainderBits > 0);
+	RemainderBits = (g_Func.nInputs*2)%BPI;
+	TotalWords    = (g_Func.nInputs*2)/BPI + (RemainderBits > 0);
 	g_CoverInfo.nVarsIn  = g_Func.nInputs;
 	g_CoverInfo.nWordsIn = TotalWords;
 	// outputs
-	RemainderBits = (g_Func.nOutputs)%(sizeof(unsigned)*8);
-	TotalWords    = (g_Func.nOutputs)/(sizeof(unsigned)*8) + (RemainderBits > 0);
+	RemainderBits = (g_Func.nOutputs)%BPI;
+	TotalWords    = (g_Func.nOutputs)/BPI + (RemainderBits > 0);
 	g_CoverInfo.nVarsOut  = g_Func.nOutputs;
 	g_CoverInfo.nWordsOut = TotalWords;
 	g_CoverInfo.cIDs = 1;
+	SelectDistanceKernels( g_CoverInfo.nWordsIn );
+
+	// the cover of this function may be in the cache
+	if ( g_CoverInfo.pCacheDir )
+	{
+		if ( !CacheComputeKey( g_Func.dd, g_Func.pOutputs, g_Func.nInputs, g_Func.nOutputs, CacheKey ) )
+		{
+			printf( "Unexpected memory allocation problem. Quitting...\n" );
+			Cudd_Quit( g_Func.dd );
+			return 0;
+		}
+		pCached = CacheRead( g_CoverInfo.pCacheDir, CacheKey, &nCached, &nCachedLits );
+		if ( g_CoverInfo.Verbosity )
+		printf( "The cache entry %s is %s\n", CacheKey, pCached? "found" : "not found" );
+	}
 
 	// cubes
 	clk1 = clock();
 //	g_CoverInfo.nCubesBefore = CountTermsInPseudoKroneckerCover( g_Func.dd, g_Func.pOutputs );
+	if ( pCached )
+		g_CoverInfo.nCubesBefore = nCached;
+	else if ( g_CoverInfo.fClasses )
+	{
+		// only the representatives of the classes of the outputs are minimized
+		pReprs = ALLOC( DdNode *, g_Func.nOutputs );
+		if ( pReprs == NULL || NpnClassifyOutputs( g_Func.dd, g_Func.pOutputs, g_Func.nOutputs, g_Func.nInputs, pReprs ) < 0 )
+		{
+			printf( "Unexpected memory allocation problem. Quitting...\n" );
+			Cudd_Quit( g_Func.dd );
+			return 0;
+		}
+		g_CoverInfo.nCubesBefore = GetNumberOfCubes( g_Func.dd, pReprs, g_Func.nOutputs );
+		FREE( pReprs );
+	}
+	else
 	g_CoverInfo.nCubesBefore = GetNumberOfCubes( g_Func.dd, g_Func.pOutputs, g_Func.nOutputs );
 	g_CoverInfo.TimeStart = clock() - clk1;
 
-	if ( g_CoverInfo.Verbosity )
+	if ( g_CoverInfo.Verbosity && !pCached )
 	{
 	printf( "Starting cover generation time is %.2f sec\n", TICKS_TO_SECONDS(g_CoverInfo.TimeStart) );
 	printf( "The number of cubes in the starting cover is %d\n", g_CoverInfo.nCubesBefore );
 	}
 
-	if ( g_CoverInfo.nCubesBefore > 20000 )
-	{
-		printf( "\nThe size of the starting cover is more than 20000 cubes. Quitting...\n" );
-		return 0;
-	}
-
 	///////////////////////////////////////////////////////////////////////
 	// STEP 2: prepare internal data structures
 	///////////////////////////////////////////////////////////////////////
@@ -186,7 +282,10 @@ int Exorcism()
 		MemTotal += MemTemp;
 
 	// allocate adjacency queques
-	MemTemp = AllocateQueques( g_CoverInfo.nCubesAlloc*g_CoverInfo.nCubesAlloc/CUBE_PAIR_FACTOR );
+	// (they start linear in the size of the cover and grow on demand,
+	// while the three of them together fit into the memory budget)
+	MemTemp = AllocateQueques( g_CoverInfo.nCubesAlloc*CUBE_PAIR_FACTOR, 
+		(int)((double)g_CoverInfo.QueBudget*(1<<20)/3/(2*sizeof(Cube*) + 2*sizeof(unsigned))) );
 	if ( MemTemp == 0 )
 	{
 		printf( "Unexpected memory allocation problem. Quitting...\n" );
@@ -196,6 +295,20 @@ int Exorcism()
 	else 
 		MemTotal += MemTemp;
 
+	// allocate the batches of cube pairs evaluated by the threads
+	if ( g_CoverInfo.nThreads > 1 )
+	{
+		MemTemp = AllocatePairBatch( g_CoverInfo.nThreads );
+		if ( MemTemp == 0 )
+		{
+			printf( "Unexpected memory allocation problem. Quitting...\n" );
+			Cudd_Quit( g_Func.dd );
+			return 0;
+		}
+		else 
+			MemTotal += MemTemp;
+	}
+
 	if ( g_CoverInfo.Verbosity )
 	printf( "Dynamically allocated memory (excluding the BDD package) is %dK\n",  MemTotal/1000 );
 
@@ -206,6 +319,13 @@ int Exorcism()
 	clk1 = clock();
 	if ( g_CoverInfo.Verbosity )
 	printf( "Generating the starting cover...\n" );
+	// the cached cover is already minimized
+	if ( pCached )
+	{
+		PortfolioInstallCover( pCached, nCached );
+		free( pCached );
+	}
+	else
 	AddCubesToStartingCover( g_Func.dd );
 	///////////////////////////////////////////////////////////////////////
 
@@ -215,15 +335,46 @@ int Exorcism()
 	if ( g_CoverInfo.Verbosity )
 	printf( "Performing minimization...\n" );
 	clk1 = clock();
-	ReduceEsopCover();
+	if ( pCached )
+		;
+	else if ( g_CoverInfo.nClusterJobs > 0 && ReduceEsopCoverClusters() )
+		;
+	else if ( g_CoverInfo.nPortfolio > 1 && ReduceEsopCoverPortfolio() )
+		;
+	else
+		ReduceEsopCover();
 	g_CoverInfo.TimeMin = clock() - clk1;
 //	g_Func.TimeMin = (float)(clock() - clk1)/(float)(CLOCKS_PER_SEC);
 	if ( g_CoverInfo.Verbosity )
 	{
 	printf( "\nMinimization time is %.2f sec\n", TICKS_TO_SECONDS(g_CoverInfo.TimeMin) );
 	printf( "\nThe number of cubes after minimization is %d\n", g_CoverInfo.nCubesInUse );
+	printf( "The cube pair queques have grown to %d places (%dK)\n", s_nPosAlloc, 
+		(int)(s_nPosAlloc*(2*sizeof(Cube*) + 2*sizeof(unsigned))/1000) );
+	if ( s_nPosDropped )
+	printf( "The number of cube pairs skipped because of the memory budget is %d\n", s_nPosDropped );
+	}
+
+	// derive the cubes of the other outputs of the classes
+	if ( g_CoverInfo.fClasses && !pCached )
+	{
+		if ( !NpnExpandCover() )
+		{
+			DelocateCubeSets();
+			DelocateCover();
+			DelocateQueques();
+			DelocatePairBatch();
+			return 0;
+		}
+		if ( g_CoverInfo.Verbosity )
+		printf( "The number of cubes after adding the outputs of the classes is %d\n", g_CoverInfo.nCubesInUse );
 	}
 
+	// save the converged cover for the later jobs
+	if ( g_CoverInfo.pCacheDir && !pCached && !g_CoverInfo.fStop )
+		if ( !CacheWrite( g_CoverInfo.pCacheDir, CacheKey ) && g_CoverInfo.Verbosity )
+			printf( "Cannot write the cache entry %s into directory \"%s\"\n", CacheKey, g_CoverInfo.pCacheDir );
+
 	///////////////////////////////////////////////////////////////////////
 	// STEP 5: save the cover into file 
 	///////////////////////////////////////////////////////////////////////
@@ -237,7 +388,7 @@ int Exorcism()
 		char Buffer[1000];
 		sprintf( Buffer, "%s.esop", g_Func.FileGeneric );
 		g_Func.FileOutput  = strsav(Buffer );
-	    WriteResultIntoFile();
+		fWritten = !WriteResultIntoFile();
 	}
 
 	///////////////////////////////////////////////////////////////////////
@@ -245,63 +396,19 @@ int Exorcism()
 	///////////////////////////////////////////////////////////////////////
 	DelocateCubeSets();
 	DelocateCover();
-	//	DelocateQueques();
+	DelocateQueques();
+	DelocatePairBatch();
 	
 	///////////////////////////////////////////////////////////////////////
 	// STEP 7: perform the final verification
 	///////////////////////////////////////////////////////////////////////
-	  //	if ( g_CoverInfo.Verbosity )
-	  //	printf( "Reading the output file(s) for verification...\n" );
-	  //	// define the data structure which stores the multi-input multi-output function
-	  //	// assign the initial parameters
-	  //	{
-	  //		// prepare to fill in the second function from the file <temp.blif>
-	  //		Func2.FileInput = strsav( g_Func.FileOutput );
-	  //		Func2.dd = g_Func.dd;
-	  //		// read the second file
-	  //		if ( Extra_ReadFile( &Func2 ) == 0 )
-	  //		{
-	  //			printf( "\nSomething did not work out while reading the output file for verification\n" );
-	  //			return 1;
-	  //		}
-	  //	}
-	  
-	  // verify the result for every output
-	  //	fVerificationOkay = 1;
-	  // the verification is done using bdds, 
-	  // even though the cover is built using ADDs
-	  //	assert( Func2.nOutputs == g_Func.nOutputs );
-	  //	for ( i = 0; i < g_Func.nOutputs; i++ )
-	  //		if ( Func2.pOutputs[i] != g_Func.pOutputs[i] )
-	  //		{
-	  //			fVerificationOkay = 0;
-	  //			printf( "Global Verification is not okay for output #%d\n", i );
-	  //			printf( "The number of wrong minterms is %d\n" , (int)Cudd_CountMinterm( g_Func.dd, Cudd_bddXor( g_Func.dd, g_Func.pOutputs[i], Func2.pOutputs[i] ), Cudd_ReadSize( g_Func.dd ) ) );
-	  ////			cout << Wrong minterms are " << ReadBdd( g_Func.dd, Cudd_bddXor( g_Func.dd, Func2.pOutputs[i], g_Func.pOutputs[i] ) ) << endl;
-	  //			printf( "The original support is\n" );
-	  //			Extra_bddPrint( g_Func.dd, Cudd_Support(g_Func.dd, g_Func.pOutputs[i]) );
-	  //			printf( "\n" );
-	  //			printf( "The resulting output is\n" );
-	  //			Extra_bddPrint( g_Func.dd, Cudd_Support(g_Func.dd, Func2.pOutputs[i]) );
-	  //			printf( "\n" );
-	  //			printf( "The original output is\n" );
-	  //			Extra_bddPrint( g_Func.dd, g_Func.pOutputs[i] );
-	  //			printf( "\n" );
-	  //			printf( "The resulting output is\n" );
-	  //			Extra_bddPrint( g_Func.dd, Func2.pOutputs[i] );
-	  //			printf( "\n" );
-	  //		}
-	  //	if ( g_CoverInfo.Verbosity )
-	  //	if ( fVerificationOkay )
-	  //		printf( "Global verification: okay for all outputs\n" );
-	  /////////////////////////////////////////////////////
-	  //
-	  // // dispose of the temporary function
-	  //	Extra_Dissolve( &Func2 );
-	  // g_Func will be disposed of in main()
+	// the Toffoli cascade is verified against the output bdds in STEP 5,
+	// when it is written (see VerifyCascade() in "exorUtil.c"); the job
+	// fails if a cascade is wrong and has not been written;
+	// g_Func will be disposed of in main()
 
 	// return success
-	return 1;
+	return fWritten;
 }
 
 int ReduceEsopCover()
@@ -323,6 +430,7 @@ int ReduceEsopCover()
 	int GainTotal;
 	int z;
 
+	s_nRounds = 0;
 	do
 	{
 //START:
@@ -332,43 +440,43 @@ int ReduceEsopCover()
 			printf( "." );
 
 		GainTotal  = 0;
-		GainTotal += IterativelyApplyExorLink2( 1|2|0 );
-		GainTotal += IterativelyApplyExorLink3( 1|2|0 );
+		GainTotal += ReduceExorLink( 2, 1|2|0 );
+		GainTotal += ReduceExorLink( 3, 1|2|0 );
 
-		GainTotal += IterativelyApplyExorLink2( 1|2|0 );
-		GainTotal += IterativelyApplyExorLink3( 1|2|0 );
+		GainTotal += ReduceExorLink( 2, 1|2|0 );
+		GainTotal += ReduceExorLink( 3, 1|2|0 );
 
-		GainTotal += IterativelyApplyExorLink2( 1|2|0 );
-		GainTotal += IterativelyApplyExorLink3( 1|2|0 );
+		GainTotal += ReduceExorLink( 2, 1|2|0 );
+		GainTotal += ReduceExorLink( 3, 1|2|0 );
 
-		GainTotal += IterativelyApplyExorLink2( 1|2|0 );
-		GainTotal += IterativelyApplyExorLink3( 1|2|0 );
+		GainTotal += ReduceExorLink( 2, 1|2|0 );
+		GainTotal += ReduceExorLink( 3, 1|2|0 );
 
-		GainTotal += IterativelyApplyExorLink2( 1|2|0 );
-		GainTotal += IterativelyApplyExorLink3( 1|2|0 );
+		GainTotal += ReduceExorLink( 2, 1|2|0 );
+		GainTotal += ReduceExorLink( 3, 1|2|0 );
 
-		GainTotal += IterativelyApplyExorLink2( 1|2|0 );
-		GainTotal += IterativelyApplyExorLink3( 1|2|0 );
+		GainTotal += ReduceExorLink( 2, 1|2|0 );
+		GainTotal += ReduceExorLink( 3, 1|2|0 );
 
 		if ( nIterWithoutImprovement > (int)(g_CoverInfo.Quality>0) )
 		{
-			GainTotal += IterativelyApplyExorLink2( 1|2|0 );
-			GainTotal += IterativelyApplyExorLink3( 1|2|0 );
-			GainTotal += IterativelyApplyExorLink2( 1|2|4 );
-			GainTotal += IterativelyApplyExorLink3( 1|2|4 );
-			GainTotal += IterativelyApplyExorLink2( 1|2|4 );
-			GainTotal += IterativelyApplyExorLink4( 1|2|4 );
-			GainTotal += IterativelyApplyExorLink2( 1|2|4 );
-			GainTotal += IterativelyApplyExorLink4( 1|2|0 );
-
-			GainTotal += IterativelyApplyExorLink2( 1|2|0 );
-			GainTotal += IterativelyApplyExorLink3( 1|2|0 );
-			GainTotal += IterativelyApplyExorLink2( 1|2|4 );
-			GainTotal += IterativelyApplyExorLink3( 1|2|4 );
-			GainTotal += IterativelyApplyExorLink2( 1|2|4 );
-			GainTotal += IterativelyApplyExorLink4( 1|2|4 );
-			GainTotal += IterativelyApplyExorLink2( 1|2|4 );
-			GainTotal += IterativelyApplyExorLink4( 1|2|0 );
+			GainTotal += ReduceExorLink( 2, 1|2|0 );
+			GainTotal += ReduceExorLink( 3, 1|2|0 );
+			GainTotal += ReduceExorLink( 2, 1|2|4 );
+			GainTotal += ReduceExorLink( 3, 1|2|4 );
+			GainTotal += ReduceExorLink( 2, 1|2|4 );
+			GainTotal += ReduceExorLink( 4, 1|2|4 );
+			GainTotal += ReduceExorLink( 2, 1|2|4 );
+			GainTotal += ReduceExorLink( 4, 1|2|0 );
+
+			GainTotal += ReduceExorLink( 2, 1|2|0 );
+			GainTotal += ReduceExorLink( 3, 1|2|0 );
+			GainTotal += ReduceExorLink( 2, 1|2|4 );
+			GainTotal += ReduceExorLink( 3, 1|2|4 );
+			GainTotal += ReduceExorLink( 2, 1|2|4 );
+			GainTotal += ReduceExorLink( 4, 1|2|4 );
+			GainTotal += ReduceExorLink( 2, 1|2|4 );
+			GainTotal += ReduceExorLink( 4, 1|2|0 );
 		}
 
 		if ( GainTotal )
@@ -379,12 +487,12 @@ int ReduceEsopCover()
 //		if ( g_CoverInfo.Quality >= 2 && nIterWithoutImprovement == 2 )
 //			s_fDecreaseLiterals = 1;
 	}
-	while ( nIterWithoutImprovement < 1 + g_CoverInfo.Quality );
+	while ( nIterWithoutImprovement < 1 + g_CoverInfo.Quality && !g_CoverInfo.fStop );
 
 
 	// improve the literal count
 	s_fDecreaseLiterals = 1;
-	for ( z = 0; z < 1; z++ )
+	for ( z = 0; z < 1 && !g_CoverInfo.fStop; z++ )
 	{
 		if ( g_CoverInfo.Verbosity == 2 )
 			printf( "\nITERATION #%d\n\n", ++nIterCount );
@@ -392,20 +500,20 @@ int ReduceEsopCover()
 			printf( "." );
 
 		GainTotal  = 0;
-		GainTotal += IterativelyApplyExorLink2( 1|2|0 );
-		GainTotal += IterativelyApplyExorLink3( 1|2|0 );
+		GainTotal += ReduceExorLink( 2, 1|2|0 );
+		GainTotal += ReduceExorLink( 3, 1|2|0 );
 
-		GainTotal += IterativelyApplyExorLink2( 1|2|0 );
-		GainTotal += IterativelyApplyExorLink3( 1|2|0 );
+		GainTotal += ReduceExorLink( 2, 1|2|0 );
+		GainTotal += ReduceExorLink( 3, 1|2|0 );
 
-		GainTotal += IterativelyApplyExorLink2( 1|2|0 );
-		GainTotal += IterativelyApplyExorLink3( 1|2|0 );
+		GainTotal += ReduceExorLink( 2, 1|2|0 );
+		GainTotal += ReduceExorLink( 3, 1|2|0 );
 
-		GainTotal += IterativelyApplyExorLink2( 1|2|0 );
-		GainTotal += IterativelyApplyExorLink3( 1|2|0 );
+		GainTotal += ReduceExorLink( 2, 1|2|0 );
+		GainTotal += ReduceExorLink( 3, 1|2|0 );
 
-		GainTotal += IterativelyApplyExorLink2( 1|2|0 );
-		GainTotal += IterativelyApplyExorLink3( 1|2|0 );
+		GainTotal += ReduceExorLink( 2, 1|2|0 );
+		GainTotal += ReduceExorLink( 3, 1|2|0 );
 
 //		if ( GainTotal )
 //		{
@@ -433,6 +541,9 @@ int ReduceEsopCover()
 //	printf( "Minimum free places in queque-4 = " << s_nPosMax[2] << endl;
 */	////////////////////////////////////////////////////////////////////
 
+	if ( g_CoverInfo.fStop && g_CoverInfo.Verbosity )
+	printf( "\nThe minimization is stopped after %d rounds; the current cover is kept\n", s_nRounds );
+
 	// write the number of cubes into cover information 
 	assert ( g_CoverInfo.nCubesInUse + g_CoverInfo.nCubesFree == g_CoverInfo.nCubesAlloc );
 
@@ -442,6 +553,269 @@ int ReduceEsopCover()
 	return 0;
 }
 
+static int ReduceExorLink( int Dist, char fDistEnable )
+// performs one round of ExorLink of the given distance, unless the minimization
+// is stopped; after the round, reports the progress and checks the time limit;
+// the cover is consistent between the rounds, so it can be kept when stopping
+// returns the number of cubes gained in the round
+{
+	Cube * p;
+	int Gain, nLiterals;
+
+	if ( g_CoverInfo.fStop )
+		return 0;
+	if ( Dist == 2 )
+		Gain = IterativelyApplyExorLink2( fDistEnable );
+	else if ( Dist == 3 )
+		Gain = IterativelyApplyExorLink3( fDistEnable );
+	else
+		Gain = IterativelyApplyExorLink4( fDistEnable );
+	s_nRounds++;
+
+	if ( g_CoverInfo.pProgress )
+	{
+		nLiterals = 0;
+		for ( p = IterCubeSetStart(); p; p = IterCubeSetNext() )
+			nLiterals += p->a;
+		if ( !g_CoverInfo.pProgress( s_nRounds, g_CoverInfo.nCubesInUse, nLiterals, 
+			(float)(GetWallTime() - g_CoverInfo.TimeBegin) ) )
+			g_CoverInfo.fStop = 1;
+	}
+	if ( g_CoverInfo.TimeStop > 0 && GetWallTime() >= g_CoverInfo.TimeStop )
+		g_CoverInfo.fStop = 1;
+	return Gain;
+}
+
+///////////////////////////////////////////////////////////////////
+///            PORTFOLIO OF THE MINIMIZATION RUNS               ///
+///////////////////////////////////////////////////////////////////
+
+// the runs of the portfolio start from the same cover and differ in the 
+// order of the cube pairs in the queques (the seed is the number of the run),
+// the order in which the groups of ExorLink-3/4 are tried (odd runs), and
+// whether the literals are reduced from the start (the runs 2,3 mod 4);
+// the run 0 is the default minimization; the other runs are performed by 
+// the child processes (the minimizer keeps its state in static variables), 
+// which send the resulting covers back to the parent through the pipes;
+// the cover with the fewest cubes (then, the fewest literals) is kept, 
+// and the ties are broken in favor of the lower run number, so the result 
+// depends only on the number of runs
+
+static int ReduceEsopCoverPortfolio()
+// performs the portfolio of minimization runs and keeps the best cover;
+// returns 0 if memory cannot be allocated (the cover is not changed then)
+{
+	int nRuns = g_CoverInfo.nPortfolio;
+	int * pFds, * pPids;
+	int Pipe[2];
+	int nCubes, nLits, nCubesBest, nLitsBest, RunBest;
+	char * pBuffer, * pBufferBest = NULL;
+	int Status, k, i;
+
+	pFds  = (int*) malloc( nRuns * sizeof(int) );
+	pPids = (int*) malloc( nRuns * sizeof(int) );
+	if ( pFds == NULL || pPids == NULL )
+	{
+		printf( "\nUnexpected memory allocation problem. Quitting...\n" );
+		if ( pFds )
+			free( pFds );
+		if ( pPids )
+			free( pPids );
+		return 0;
+	}
+
+	// make sure the output printed so far is not repeated by the children
+	fflush( stdout );
+
+	// start the runs 1, 2, ... in the child processes
+	for ( k = 1; k < nRuns; k++ )
+	{
+		if ( pipe( Pipe ) == -1 )
+			break;
+		pPids[k] = (int)fork();
+		if ( pPids[k] == -1 )
+		{
+			close( Pipe[0] );
+			close( Pipe[1] );
+			break;
+		}
+		if ( pPids[k] == 0 )
+		{ // the child performs its run and sends the cover
+			close( Pipe[0] );
+			for ( i = 1; i < k; i++ )
+				close( pFds[i] );
+			g_CoverInfo.Verbosity = 0;
+			PortfolioSetStrategy( k );
+			ReduceEsopCover();
+			_exit( PortfolioSendCover( Pipe[1] ) == 0 );
+		}
+		close( Pipe[1] );
+		pFds[k] = Pipe[0];
+	}
+	if ( k < nRuns && g_CoverInfo.Verbosity )
+		printf( "Cannot start more than %d portfolio runs\n", k );
+	nRuns = k;
+
+	// the parent performs the run 0
+	PortfolioSetStrategy( 0 );
+	ReduceEsopCover();
+	nCubesBest = g_CoverInfo.nCubesInUse;
+	nLitsBest  = CountLiterals();
+	RunBest    = 0;
+	if ( g_CoverInfo.Verbosity )
+		printf( "\nPortfolio run %2d: Cubes = %5d  Literals = %6d\n", 0, nCubesBest, nLitsBest );
+
+	// collect the covers of the other runs
+	for ( k = 1; k < nRuns; k++ )
+	{
+		pBuffer = PortfolioReceiveCover( pFds[k], &nCubes, &nLits );
+		close( pFds[k] );
+		waitpid( (pid_t)pPids[k], &Status, 0 );
+		if ( pBuffer == NULL )
+		{
+			if ( g_CoverInfo.Verbosity )
+				printf( "Portfolio run %2d: failed\n", k );
+			continue;
+		}
+		if ( g_CoverInfo.Verbosity )
+			printf( "Portfolio run %2d: Cubes = %5d  Literals = %6d\n", k, nCubes, nLits );
+		if ( nCubesBest > nCubes || (nCubesBest == nCubes && nLitsBest > nLits) )
+		{
+			if ( pBufferBest )
+				free( pBufferBest );
+			pBufferBest = pBuffer;
+			nCubesBest = nCubes;
+			nLitsBest  = nLits;
+			RunBest    = k;
+		}
+		else
+			free( pBuffer );
+	}
+
+	// take the best cover
+	if ( pBufferBest )
+	{
+		PortfolioInstallCover( pBufferBest, nCubesBest );
+		free( pBufferBest );
+	}
+	if ( g_CoverInfo.Verbosity )
+		printf( "The best cover is produced by portfolio run %d\n", RunBest );
+
+	free( pFds );
+	free( pPids );
+	return 1;
+}
+
+static void PortfolioSetStrategy( int Run )
+// sets the strategy of the given portfolio run
+{
+	if ( Run > 0 )
+		ShuffleQueques( (unsigned)Run );
+	ExorLinkSetGroupOrder( Run & 1 );
+	if ( Run & 2 )
+		s_fDecreaseLiterals = 1;
+}
+
+static int PortfolioSendCover( int fd )
+// writes the cover into the pipe: the numbers of cubes and literals,
+// then the records of the cubes (see CubeRecordWrite() in "exorCubes.c");
+// returns 1 on success
+{
+	int nCubeBytes = CubeRecordSize();
+	int Header[2];
+	char * pBuffer, * pCur;
+	Cube * p;
+	int RetValue;
+
+	Header[0] = g_CoverInfo.nCubesInUse;
+	Header[1] = CountLiterals();
+	pBuffer = (char*) malloc( Header[0] * nCubeBytes + 1 );
+	if ( pBuffer == NULL )
+		return 0;
+	pCur = pBuffer;
+	for ( p = IterCubeSetStart( ); p; p = IterCubeSetNext() )
+		pCur = CubeRecordWrite( pCur, p->a, p->z, p->pCubeDataIn, p->pCubeDataOut );
+	assert( pCur == pBuffer + Header[0] * nCubeBytes );
+
+	RetValue = PortfolioTransfer( fd, (char*)Header, sizeof(Header), 1 ) &&
+		       PortfolioTransfer( fd, pBuffer, Header[0] * nCubeBytes, 1 );
+	free( pBuffer );
+	return RetValue;
+}
+
+static char* PortfolioReceiveCover( int fd, int* pnCubes, int* pnLits )
+// reads the cover written by PortfolioSendCover() from the pipe
+// returns the cube data, or NULL if the cover cannot be received
+{
+	int nCubeBytes = CubeRecordSize();
+	int Header[2];
+	char * pBuffer;
+
+	if ( !PortfolioTransfer( fd, (char*)Header, sizeof(Header), 0 ) || Header[0] < 0 )
+		return NULL;
+	pBuffer = (char*) malloc( Header[0] * nCubeBytes + 1 );
+	if ( pBuffer == NULL )
+		return NULL;
+	if ( !PortfolioTransfer( fd, pBuffer, Header[0] * nCubeBytes, 0 ) )
+	{
+		free( pBuffer );
+		return NULL;
+	}
+	*pnCubes = Header[0];
+	*pnLits  = Header[1];
+	return pBuffer;
+}
+
+static void PortfolioInstallCover( char* pBuffer, int nCubes )
+// replaces the cubes of the current cover by the cubes in the buffer;
+// the cube pairs remaining in the queques become outdated
+{
+	Cube * p, * pNext;
+	char * pCur;
+	int c;
+
+	// remove the current cubes (the iterator moves on before the cube is extracted)
+	for ( p = IterCubeSetStart( ); p; p = pNext )
+	{
+		pNext = IterCubeSetNext();
+		AddToFreeCubes( CubeExtract( p ) );
+	}
+
+	// add the new cubes
+	pCur = pBuffer;
+	for ( c = 0; c < nCubes; c++ )
+	{
+		p = GetFreeCube();
+		pCur = CubeRecordRead( pCur, p );
+		p->fMark = 0;
+		// set the ID
+		p->ID = g_CoverInfo.cIDs++;
+		// skip through zero-ID
+		if ( g_CoverInfo.cIDs == 0 )
+			g_CoverInfo.cIDs = 1;
+		CubeInsert( p );
+	}
+}
+
+static int PortfolioTransfer( int fd, char* pBuffer, int nBytes, int fWrite )
+// reads/writes the given number of bytes from/into the pipe
+// returns 1 on success, 0 if the pipe is closed or broken
+{
+	int nDone;
+	while ( nBytes > 0 )
+	{
+		if ( fWrite )
+			nDone = (int)write( fd, pBuffer, nBytes );
+		else
+			nDone = (int)read( fd, pBuffer, nBytes );
+		if ( nDone <= 0 )
+			return 0;
+		pBuffer += nDone;
+		nBytes  -= nDone;
+	}
+	return 1;
+}
+
 //////////////////////////////////////////////////////////////////
 // quite a good script
 //////////////////////////////////////////////////////////////////
@@ -800,6 +1174,248 @@ alu4 = 435   70 secs
 	while ( nIterWithoutImprovement < 1 + g_CoverInfo.Quality );
 */
 
+static int ReduceEsopCoverClusters()
+// groups the outputs into the clusters with disjoint supports and minimizes
+// the cubes of each cluster in a child process (at most nClusterJobs at a time);
+// the cubes of different clusters cannot be merged anyway, while the pairs
+// of such cubes fill the queques; the covers of the clusters are collected
+// into the cover; returns 0 if there is only one cluster, if memory cannot be
+// allocated, or if some cluster cannot be minimized (the starting cover is not
+// changed in this case)
+{
+	int nOutputs = g_CoverInfo.nVarsOut;
+	int nWords = g_CoverInfo.nWordsOut;
+	int nCubeBytes = CubeRecordSize();
+	int * pClusters, * pFds, * pPids, * pnCubes;
+	int nClusters, nCubesAll, Pipe[2], fFailed = 0, fOther, k, i, o, w;
+	char ** pBuffers, * pBuffer;
+	word * pMasks;
+	Cube * p, * pNext;
+
+	pClusters = ALLOC( int, nOutputs );
+	if ( pClusters == NULL )
+		return 0;
+	nClusters = ClusterOutputs( g_Func.dd, g_Func.pOutputs, nOutputs, pClusters );
+	if ( g_CoverInfo.Verbosity )
+		printf( "The outputs fall into %d clusters with disjoint supports\n", nClusters );
+	if ( nClusters < 2 )
+	{
+		FREE( pClusters );
+		return 0;
+	}
+
+	pFds     = ALLOC( int, nClusters );
+	pPids    = ALLOC( int, nClusters );
+	pnCubes  = ALLOC( int, nClusters );
+	pBuffers = ALLOC( char *, nClusters );
+	pMasks   = ALLOC( word, nClusters * nWords );
+	if ( pFds == NULL || pPids == NULL || pnCubes == NULL || pBuffers == NULL || pMasks == NULL )
+	{
+		printf( "\nUnexpected memory allocation problem. Quitting...\n" );
+		FREE( pClusters );
+		FREE( pFds );
+		FREE( pPids );
+		FREE( pnCubes );
+		FREE( pBuffers );
+		FREE( pMasks );
+		return 0;
+	}
+	memset( pMasks, 0, sizeof(word) * nClusters * nWords );
+	for ( o = 0; o < nOutputs; o++ )
+		pMasks[pClusters[o] * nWords + o/BPI] |= ((word)1) << (o%BPI);
+	for ( k = 0; k < nClusters; k++ )
+		pBuffers[k] = NULL;
+
+	// make sure the output printed so far is not repeated by the children
+	fflush( stdout );
+
+	// start the clusters in the child processes;
+	// the clusters i, i+1, ..., k-1 are running
+	for ( k = i = 0; k < nClusters; k++ )
+	{
+		if ( k - i == g_CoverInfo.nClusterJobs )
+		{
+			pBuffers[i] = ClusterCollect( pFds[i], pPids[i], pnCubes + i );
+			i++;
+		}
+		if ( pipe( Pipe ) == -1 )
+		{
+			fFailed = 1;
+			break;
+		}
+		pPids[k] = (int)fork();
+		if ( pPids[k] == -1 )
+		{
+			close( Pipe[0] );
+			close( Pipe[1] );
+			fFailed = 1;
+			break;
+		}
+		if ( pPids[k] == 0 )
+		{ // the child minimizes the cubes of its cluster and sends the cover
+			close( Pipe[0] );
+			for ( o = i; o < k; o++ )
+				close( pFds[o] );
+			g_CoverInfo.Verbosity = 0;
+			// a cube shared with other clusters (e.g. the cube without literals 
+			// shared by the constant outputs) keeps only the outputs of this cluster,
+			// otherwise it would be sent by several children
+			for ( p = IterCubeSetStart( ); p; p = pNext )
+			{
+				pNext = IterCubeSetNext();
+				for ( fOther = 0, w = 0; w < nWords; w++ )
+					if ( p->pCubeDataOut[w] & ~pMasks[k * nWords + w] )
+						fOther = 1;
+				if ( !fOther )
+					continue;
+				CubeExtract( p );
+				for ( w = 0; w < nWords; w++ )
+					p->pCubeDataOut[w] &= pMasks[k * nWords + w];
+				p->z = 0;
+				for ( o = 0; o < nOutputs; o++ )
+					p->z += ( (p->pCubeDataOut[o/BPI] & (((word)1) << (o%BPI))) != 0 );
+				if ( p->z )
+					CubeInsert( p );
+				else
+					AddToFreeCubes( p );
+			}
+			if ( g_CoverInfo.nPortfolio > 1 && ReduceEsopCoverPortfolio() )
+				;
+			else
+				ReduceEsopCover();
+			// the exit code tells the parent whether the time limit was reached
+			_exit( PortfolioSendCover( Pipe[1] ) == 0? 1 : 2 * g_CoverInfo.fStop );
+		}
+		close( Pipe[1] );
+		pFds[k] = Pipe[0];
+	}
+	// collect the remaining clusters
+	for ( ; i < k; i++ )
+		pBuffers[i] = ClusterCollect( pFds[i], pPids[i], pnCubes + i );
+
+	// concatenate the covers of the clusters
+	nCubesAll = 0;
+	for ( k = 0; k < nClusters; k++ )
+	{
+		if ( pBuffers[k] == NULL )
+			fFailed = 1;
+		else
+			nCubesAll += pnCubes[k];
+	}
+	pBuffer = fFailed? NULL : (char*) malloc( nCubesAll * nCubeBytes + 1 );
+	if ( pBuffer )
+	{
+		for ( nCubesAll = k = 0; k < nClusters; k++ )
+		{
+			memcpy( pBuffer + nCubesAll * nCubeBytes, pBuffers[k], pnCubes[k] * nCubeBytes );
+			nCubesAll += pnCubes[k];
+		}
+		PortfolioInstallCover( pBuffer, nCubesAll );
+		free( pBuffer );
+	}
+	else if ( g_CoverInfo.Verbosity )
+		printf( "Minimization of the clusters has failed; the outputs are minimized together\n" );
+
+	for ( k = 0; k < nClusters; k++ )
+		if ( pBuffers[k] )
+			free( pBuffers[k] );
+	FREE( pClusters );
+	FREE( pFds );
+	FREE( pPids );
+	FREE( pnCubes );
+	FREE( pBuffers );
+	FREE( pMasks );
+	return pBuffer != NULL;
+}
+
+static int ClusterOutputs( DdManager * dd, DdNode ** pOutputs, int nOutputs, int * pClusters )
+// puts two outputs into the same cluster if their supports overlap
+// (directly or through other outputs); the constant outputs form one cluster,
+// so that their cube without literals is not split; the clusters are numbered
+// in the order of their first outputs; returns the number of clusters
+// (0 if memory cannot be allocated)
+{
+	int * pParents, * pFirst, * pSupp;
+	int nClusters = 0, oConst = -1, fConst, o, v;
+
+	pParents = ALLOC( int, nOutputs );
+	pFirst   = ALLOC( int, Cudd_ReadSize(dd) );
+	if ( pParents == NULL || pFirst == NULL )
+	{
+		printf( "\nUnexpected memory allocation problem. Quitting...\n" );
+		FREE( pParents );
+		FREE( pFirst );
+		return 0;
+	}
+	for ( v = 0; v < Cudd_ReadSize(dd); v++ )
+		pFirst[v] = -1;
+	for ( o = 0; o < nOutputs; o++ )
+	{
+		pParents[o] = o;
+		pSupp = Cudd_SupportIndex( dd, pOutputs[o] );
+		if ( pSupp == NULL )
+		{
+			printf( "\nUnexpected memory allocation problem. Quitting...\n" );
+			FREE( pParents );
+			FREE( pFirst );
+			return 0;
+		}
+		fConst = 1;
+		for ( v = 0; v < Cudd_ReadSize(dd); v++ )
+			if ( pSupp[v] )
+			{
+				// the variable joins the clusters of the outputs
+				if ( pFirst[v] == -1 )
+					pFirst[v] = o;
+				else
+					pParents[ClusterFind( pParents, o )] = ClusterFind( pParents, pFirst[v] );
+				fConst = 0;
+			}
+		FREE( pSupp );
+		// the constant output joins the cluster of the first constant output
+		if ( fConst && oConst == -1 )
+			oConst = o;
+		else if ( fConst )
+			pParents[ClusterFind( pParents, o )] = ClusterFind( pParents, oConst );
+	}
+	// number the clusters
+	for ( o = 0; o < nOutputs; o++ )
+		pClusters[o] = -1;
+	for ( o = 0; o < nOutputs; o++ )
+	{
+		v = ClusterFind( pParents, o );
+		if ( pClusters[v] == -1 )
+			pClusters[v] = nClusters++;
+		pClusters[o] = pClusters[v];
+	}
+	FREE( pParents );
+	FREE( pFirst );
+	return nClusters;
+}
+
+static int ClusterFind( int * pParents, int Out )
+// returns the root of the tree of the output (and shortens the path)
+{
+	while ( pParents[Out] != Out )
+		Out = pParents[Out] = pParents[pParents[Out]];
+	return Out;
+}
+
+static char* ClusterCollect( int fd, int Pid, int* pnCubes )
+// receives the cover of the cluster from the pipe and waits for the child;
+// returns the cube data, or NULL if the cover cannot be received
+{
+	char * pBuffer;
+	int nLits, Status;
+
+	pBuffer = PortfolioReceiveCover( fd, pnCubes, &nLits );
+	close( fd );
+	waitpid( (pid_t)Pid, &Status, 0 );
+	if ( WIFEXITED(Status) && WEXITSTATUS(Status) == 2 )
+		g_CoverInfo.fStop = 1;
+	return pBuffer;
+}
+
 ///////////////////////////////////////////////////////////////////
 ////////////              End of File             /////////////////
 ///////////////////////////////////////////////////////////////////
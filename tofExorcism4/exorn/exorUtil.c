@@ -27,6 +27,7 @@
 
 #include "exor.h"
 #include "extra.h"
+#include <sys/time.h>
 
 ////////////////////////////////////////////////////////////////////////
 ///                      EXTERNAL VARIABLES                         ////
@@ -39,18 +40,23 @@ extern float betaC ;
 extern int hasNots ;
 extern int costFunc ;
 extern int removeNots ;
+extern int optimizeGates ;
+extern int nSweep ;
+extern int fBinaryTfc ;
+extern int fMetricsFile ;
 
 extern BFunc g_Func;
 extern cinfo g_CoverInfo;
+extern tstats * g_pStats;
+extern char * g_FileTfc;
 
 //statics
 static long reorderTicks = 0 ;
 static long notRemovalTicks = 0 ;
+static long peepholeTicks = 0 ;
 static long numGates = 0 ;
 static long numNots = 0 ;
 
-static tmpNumNots = 0 ;
-
 ///////////////////////////////////////////////////////////////////////
 ///                        EXTERNAL FUNCTIONS                        ///
 ////////////////////////////////////////////////////////////////////////
@@ -67,6 +73,26 @@ extern varvalue GetVar( Cube* pC, int Var );
 // converts Value into a string
 extern char* itoa( int Value, char* Buff, int Radix );
 
+// the Toffoli cascade
+extern tcascade * CascadeAlloc( int nLinesIn, int nOutputs );
+extern void CascadeFree( tcascade * p );
+extern void CascadeRestart( tcascade * p, int nLinesIn, int nOutputs );
+extern int CascadeAddGate( tcascade * p, word * pControls, int nControls, int Target );
+extern int CascadeCountNots( tcascade * p );
+extern double CascadeQuantumCost( tcascade * p );
+extern int CascadeOptimize( tcascade * p );
+extern void CascadeWriteTfcGates( tcascade * p, FILE * pFile, tmetrics * pMetrics );
+extern void CascadeWriteBinary( tcascade * p, FILE * pFile, tmetrics * pMetrics );
+
+// the metrics of the Toffoli cascade
+extern int  MetricsStart( tmetrics * p, tcascade * pCas );
+extern void MetricsStop( tmetrics * p );
+extern int  MetricsWriteFile( tmetrics * p, tstats * pStats, char * pFileName );
+
+// verification of the Toffoli cascade
+extern int CascadeVerifySim( tcascade * p, DdManager * dd, DdNode ** pOutputs, int nInputs );
+extern int CascadeVerifyBdd( tcascade * p, DdManager * dd, DdNode ** pOutputs, int nInputs );
+
 ////////////////////////////////////////////////////////////////////////
 ///                      FUNCTION DECLARATIONS                       ///
 ////////////////////////////////////////////////////////////////////////
@@ -80,6 +106,14 @@ extern char* itoa( int Value, char* Buff, int Radix );
 ////////////       Cover Service Procedures       /////////////////
 ///////////////////////////////////////////////////////////////////
 
+double GetWallTime()
+// returns the wall-clock time in seconds
+{
+	struct timeval tv;
+	gettimeofday( &tv, NULL );
+	return (double)tv.tv_sec + 1.0e-6 * (double)tv.tv_usec;
+}
+
 int CountLiterals()
 // nCubesAlloc is the number of allocated cubes 
 {
@@ -114,44 +148,148 @@ int CountLiterals()
 	return LitCounter;
 }
 
-/*global cube list set defined in exorList.c*/
-extern Cube *s_List ;
-extern Cube *s_pCubeLast ;
-
-void calcVarCost(Cube *startCube, Cube *endCube, char *ignoreVar, int *bestVar) {
-  Cube *cube = startCube ;
-  int *alpha = (int*)malloc(sizeof(int)*g_Func.nInputs) ;
-  int *beta = (int*)malloc(sizeof(int)*g_Func.nInputs) ;
+//the gates of the cascade are kept in the gate buffer as integers:
+//a non-negative entry is the index of a cube in s_pCubes,
+//an entry below GATE_NONE is the "not" gate on the input line GATE_LINE(g),
+//and GATE_NONE is the gate removed from the sequence
+#define GATE_NONE      (-1)
+#define GATE_NOT(v)    (-(v)-2)
+#define GATE_IS_NOT(g) ((g) < GATE_NONE)
+#define GATE_LINE(g)   (-(g)-2)
+
+//the scratch arena of the reordering; the arrays are allocated
+//when the first cascade is generated, reused by the following ones
+//(the points of the sweep), and freed by ReorderArenaFree()
+static Cube **s_pCubes = NULL ;  //the cubes of the cover
+static int *s_pPerm = NULL ;     //the permutation of the cube indices
+static int *s_pTemp = NULL ;     //the scratch space for splitting the permutation
+static int s_nCubes = 0 ;
+static int s_nCubesAlloc = 0 ;
+static int *s_pGates = NULL ;    //the gate buffer
+static int s_nGates = 0 ;
+static int s_nGatesAlloc = 0 ;
+static int *s_pCounters = NULL ; //the per-variable counters, one row for each level
+static int s_nCountersAlloc = 0 ;
+static char *s_pIgnoreVar = NULL ;
+static word *s_pMask = NULL ;    //the control mask of one gate
+static int *s_pNotPos = NULL ;   //the position of the pending "not" gate of each line
+static word *s_pNotMask = NULL ; //the lines with a pending "not" gate (in the cube layout)
+static tcascade *s_pCascade = NULL ; //the cascade
+static int s_nVarsAlloc = 0 ;
+
+int ReorderArenaPrepare() {
+  //collects the cubes of the cover into the arena and makes sure
+  //the arrays are large enough; returns 0 if memory cannot be allocated
+  Cube *p ;
+  int nNegLits = 0 ;
+  int nGatesMax ;
+  int v ;
 
-  memset(alpha, 0, sizeof(int)*g_Func.nInputs) ;
-  memset(beta, 0, sizeof(int)*g_Func.nInputs) ;
+  //the number of "not" pairs does not exceed the number of negative literals,
+  //because each pair is charged to a negative literal of the first cube it
+  //encloses and the variable of the pair is not split again inside it
+  s_nCubes = 0 ;
+  for ( p = IterCubeSetStart( ); p; p = IterCubeSetNext() ) {
+    if(s_nCubes == s_nCubesAlloc) {
+      s_nCubesAlloc = s_nCubesAlloc ? 2*s_nCubesAlloc : g_CoverInfo.nCubesInUse + 16 ;
+      s_pCubes = (Cube**)realloc(s_pCubes, sizeof(Cube*)*s_nCubesAlloc) ;
+      s_pPerm = (int*)realloc(s_pPerm, sizeof(int)*s_nCubesAlloc) ;
+      s_pTemp = (int*)realloc(s_pTemp, sizeof(int)*s_nCubesAlloc) ;
+      if(!s_pCubes || !s_pPerm || !s_pTemp) {
+	return 0 ;
+      }
+    }
+    s_pCubes[s_nCubes++] = p ;
+    for ( v = 0; v < g_Func.nInputs; v++ ) {
+      if(GetVar( p, v ) == VAR_NEG) {
+	nNegLits++ ;
+      }
+    }
+  }
 
-  int i ;
+  nGatesMax = s_nCubes + 2*nNegLits ;
+  if(nGatesMax > s_nGatesAlloc) {
+    s_nGatesAlloc = nGatesMax ;
+    s_pGates = (int*)realloc(s_pGates, sizeof(int)*s_nGatesAlloc) ;
+    if(!s_pGates) {
+      return 0 ;
+    }
+  }
 
-  //do this so I can pass in null to mean the last cube in the list
-  Cube *_end = 0 ; 
-  if(endCube==0) {
-    _end = 0 ;
+  if(g_Func.nInputs > s_nVarsAlloc || g_Func.nOutputs > s_nVarsAlloc) {
+    s_nVarsAlloc = (g_Func.nInputs > g_Func.nOutputs) ? g_Func.nInputs : g_Func.nOutputs ;
+    s_pIgnoreVar = (char*)realloc(s_pIgnoreVar, sizeof(char)*s_nVarsAlloc) ;
+    s_pMask = (word*)realloc(s_pMask, sizeof(word)*((3*s_nVarsAlloc+BPI-1)/BPI)) ;
+    s_pNotPos = (int*)realloc(s_pNotPos, sizeof(int)*s_nVarsAlloc) ;
+    s_pNotMask = (word*)realloc(s_pNotMask, sizeof(word)*((2*s_nVarsAlloc+BPI-1)/BPI)) ;
+    if(!s_pIgnoreVar || !s_pMask || !s_pNotPos || !s_pNotMask) {
+      return 0 ;
+    }
   }
-  else {
-    _end = endCube->Next ;
+
+  //the alpha and beta counters of each level of the recursion plus one
+  if(2*g_Func.nInputs*(g_Func.nInputs+2) > s_nCountersAlloc) {
+    s_nCountersAlloc = 2*g_Func.nInputs*(g_Func.nInputs+2) ;
+    s_pCounters = (int*)realloc(s_pCounters, sizeof(int)*s_nCountersAlloc) ;
+    if(!s_pCounters) {
+      return 0 ;
+    }
   }
+  return 1 ;
+}
 
-  for(cube=startCube ; cube != _end ; cube=cube->Next) {
-    for(i=0 ; i<g_Func.nInputs ; i++) {
-      if(!ignoreVar[i]) {
-	int Value = GetVar( cube, i );
-	if ( Value == VAR_NEG ) {
+void ReorderArenaFree() {
+  free(s_pCubes) ;    s_pCubes = NULL ;
+  free(s_pPerm) ;     s_pPerm = NULL ;
+  free(s_pTemp) ;     s_pTemp = NULL ;
+  free(s_pGates) ;    s_pGates = NULL ;
+  free(s_pCounters) ; s_pCounters = NULL ;
+  free(s_pIgnoreVar) ; s_pIgnoreVar = NULL ;
+  free(s_pMask) ;     s_pMask = NULL ;
+  CascadeFree(s_pCascade) ; s_pCascade = NULL ;
+  free(s_pNotPos) ;   s_pNotPos = NULL ;
+  free(s_pNotMask) ;  s_pNotMask = NULL ;
+  s_nCubes = s_nCubesAlloc = 0 ;
+  s_nGates = s_nGatesAlloc = 0 ;
+  s_nVarsAlloc = 0 ;
+  s_nCountersAlloc = 0 ;
+}
+
+void countVars(int start, int stop, int *alpha, int *beta) {
+  //computes the counters of the variables in the cubes s_pPerm[start..stop-1]:
+  //alpha[i] is the number of literals of i, beta[i] is the number of positive
+  //minus the number of negative literals; only the literals are visited
+  Cube *cube ;
+  word Data, Neg, Pos ;
+  int k, w, i ;
+
+  memset(alpha, 0, sizeof(int)*g_Func.nInputs) ;
+  memset(beta, 0, sizeof(int)*g_Func.nInputs) ;
+
+  for(k=start ; k<stop ; k++) {
+    cube = s_pCubes[s_pPerm[k]] ;
+    for(w=0 ; w<g_CoverInfo.nWordsIn ; w++) {
+      Data = cube->pCubeDataIn[w] ;
+      //the lower bits of the variables with the value VAR_NEG and VAR_POS
+      Neg = Data & ~(Data>>1) & DIFFERENT ;
+      Pos = (Data>>1) & ~Data & DIFFERENT ;
+      for(i = w*(BPI/2) ; Neg|Pos ; i++, Neg>>=2, Pos>>=2) {
+	if(Neg&1) {
 	  alpha[i] +=  1 ;
 	  beta[i]  += -1 ;
 	}
-	else if ( Value == VAR_POS ) {
+	else if(Pos&1) {
 	  alpha[i] +=  1 ;
 	  beta[i]  +=  1 ;
 	}
       }
     }
   }
+}
+
+void calcVarCost(int *alpha, int *beta, char *ignoreVar, int *bestVar) {
+  //finds the best variable to split the cubes with the given counters
+  int i ;
 
   float cost = -1e10 ;
   *bestVar = -1 ;
@@ -173,96 +311,27 @@ void calcVarCost(Cube *startCube, Cube *endCube, char *ignoreVar, int *bestVar)
       }
     }
   }
-
-  free(alpha) ;
-  free(beta) ;
 }
 
-void splitCubes(Cube *start, Cube *end, int bestVar, Cube **start1, Cube **start2, Cube **end1, Cube **end2) {
-  Cube *_end ;
-  if(end==0) {
-    _end = 0 ;
-  }
-  else {
-    _end = end->Next ;
-  }
-
-  Cube *cube ;
-  Cube *cube1 = 0 ;
-  Cube *cube2 = 0 ;
-  Cube *nextCube ;
-
-  if(cube != 0) {
-    nextCube = start->Next ;
-  }
-  else {
-    nextCube = 0 ;
-  }
+int splitCubes(int start, int stop, int bestVar) {
+  //stably partitions the cubes s_pPerm[start..stop-1] into those with
+  //the positive literal or without bestVar, followed by those with
+  //the negative literal; returns the position of the second part
+  int k, mid, nNeg = 0 ;
 
-  *start1 = 0 ;
-  *start2 = 0 ;
-
-
-  for(cube = start ; cube != _end ; cube=nextCube) {
-    nextCube = cube->Next ;
-    int Value = GetVar( cube, bestVar );
+  for(mid=k=start ; k<stop ; k++) {
+    int Value = GetVar( s_pCubes[s_pPerm[k]], bestVar );
     if ( Value == VAR_NEG ) {
-      if(*start2==0) {
-	*start2 = cube ;
-	cube2 = cube ;
-	cube2->Prev = 0 ;
-	cube2->Next = 0 ;
-      }
-      else {
-	cube2->Next = cube ;
-	cube->Prev = cube2 ;
-	cube->Next = 0 ;
-	cube2 = cube ;
-      }
+      s_pTemp[nNeg++] = s_pPerm[k] ;
     }
     else if ( Value == VAR_POS || Value == VAR_ABS ) {
-      if(*start1==0) {
-	*start1 = cube ;
-	cube1 = cube ;
-	cube1->Prev = 0 ;
-	cube1->Next = 0 ;
-      }
-      else {
-	cube1->Next = cube ;
-	cube->Prev = cube1 ;
-	cube->Next = 0 ;
-	cube1 = cube ;
-      }
+      s_pPerm[mid++] = s_pPerm[k] ;
     }
     else
       assert(0);
   }
-
-  *end1 = cube1 ;
-  *end2 = cube2 ;
-}
-
-Cube* connectLists(Cube *start1, Cube *start2, Cube *end1, Cube *end2, Cube **newStart, Cube **newEnd) {
-  if(start1!=0) {
-    *newStart = start1 ;
-    start1->Prev = 0 ;
-    if(start2 != 0) {
-      end1->Next = start2 ;
-      start2->Prev = end1 ;
-      end2->Next = 0 ;
-      *newEnd = end2 ;
-    }
-    else {
-      end1->Next = 0 ;
-      *newEnd = end1 ;
-    }
-  }
-  else if(start2!=0) {
-    *newStart = start2 ;
-    start2->Prev = end1 ;
-    end2->Next = 0 ;
-    *newEnd = end2 ;
-  }
+  memcpy(s_pPerm+mid, s_pTemp, sizeof(int)*nNeg) ;
+  return mid ;
 }
 
 void printCube(Cube *cube, FILE *file) {
@@ -285,118 +354,128 @@ void printCube(Cube *cube, FILE *file) {
   fprintf(file, "\n") ;
 }
 
-void printCubes(Cube *start, Cube *end, FILE *file) {
-  Cube *_end = 0 ;
-  if(end==0) {
-    _end = 0 ;
-  }
-  else {
-    _end = end->Next ;
-  }
-
-  Cube *cube ;
-  for(cube=start ; cube != _end ; cube=cube->Next) {
-    printCube(cube, file) ;
+void printCubes(int start, int stop, FILE *file) {
+  int k ;
+  for(k=start ; k<stop ; k++) {
+    printCube(s_pCubes[s_pPerm[k]], file) ;
   }
-
 }
 
-void _reorderCubes(Cube *start, Cube *end, Cube **newStart, Cube **newEnd, char *ignoreVar, int *level, int invert) {
-  if(start==0) {
-    *newStart = start ;
-    *newEnd = end ;
+void _reorderCubes(int start, int stop, char *ignoreVar, int *level, int invert, int *pCnt, int *pFree) {
+  //appends the gates of the cubes s_pPerm[start..stop-1] to the gate buffer;
+  //pCnt are the counters of these cubes (they are overwritten),
+  //pFree is the space for the counters of the levels below
+  int nVars = g_Func.nInputs ;
+  int *pCnt1, *pCnt2 ;
+  int k ;
+
+  if(start==stop) {
     return ;
   }
 
   if(*level==0) {
-    *newStart = start ;
-    *newEnd = end ;
+    for(k=start ; k<stop ; k++) {
+      s_pGates[s_nGates++] = s_pPerm[k] ;
+    }
+    return ;
+  }
+
+  //for one cube, the remaining variables are split one after another,
+  //and all variables of the same kind (positive, negative, absent) get
+  //the same score, so the negative literals are split in the order of
+  //their indices; the cube is enclosed by the "not" pairs of these literals
+  if(stop-start==1) {
+    Cube *cube = s_pCubes[s_pPerm[start]] ;
+    int nNots = 0 ;
+    if(invert!=2) {
+      for(k=0 ; k<nVars ; k++) {
+	if(!ignoreVar[k] && GetVar( cube, k ) == VAR_NEG) {
+	  s_pGates[s_nGates++] = GATE_NOT(k) ;
+	  nNots++ ;
+	}
+      }
+    }
+    s_pGates[s_nGates++] = s_pPerm[start] ;
+    for(k=0 ; k<nNots ; k++) {
+      s_pGates[s_nGates] = s_pGates[s_nGates-2-2*k] ;
+      s_nGates++ ;
+    }
     return ;
   }
 
   //calculate best var
   int bestVar = -1 ;
-  calcVarCost(start, end, ignoreVar, &bestVar) ;
+  calcVarCost(pCnt, pCnt+nVars, ignoreVar, &bestVar) ;
   //  fprintf(stderr, "best var: %d , level: %d , invert: %d\n", bestVar, *level, invert) ;
   //split the cube list into two lists   
-  Cube *start1 = 0 ;
-  Cube *start2 = 0 ;
-  Cube *end1 = 0 ;
-  Cube *end2 = 0 ;
-  Cube *newStart1 = 0 ;
-  Cube *newStart2 = 0 ;
-  Cube *newEnd1 = 0 ;
-  Cube *newEnd2 = 0 ;
-  //    fprintf(stderr, "original list\n") ;
-  //    printCubes(start, end, stderr) ;
-  splitCubes(start, end, bestVar, &start1, &start2, &end1, &end2) ;
-  //    fprintf(stderr, "split list 1\n") ;
-  //    printCubes(start1, end1, stderr) ;
-  //    fprintf(stderr, "split list 2\n") ;
-  //    printCubes(start2, end2, stderr) ;
+  int mid = splitCubes(start, stop, bestVar) ;
 
   //set ignoreVar[bestVar] to true
   ignoreVar[bestVar] = 1 ;
   (*level)-- ;
+
+  //the counters of the smaller list are computed and subtracted
+  //from those of this list, which gives the counters of the larger list
+  if(mid-start <= stop-mid) {
+    pCnt1 = pFree ;
+    pCnt2 = pCnt ;
+  }
+  else {
+    pCnt1 = pCnt ;
+    pCnt2 = pFree ;
+  }
+  if(*level > 0) {
+    if(pCnt1 == pFree) {
+      countVars(start, mid, pFree, pFree+nVars) ;
+    }
+    else {
+      countVars(mid, stop, pFree, pFree+nVars) ;
+    }
+    for(k=0 ; k<2*nVars ; k++) {
+      pCnt[k] -= pFree[k] ;
+    }
+  }
+  pFree += 2*nVars ;
+
   //order each sublist
   if(invert!=2) {
-    _reorderCubes(start1, end1, &newStart1, &newEnd1, ignoreVar, level, 0) ;
-    _reorderCubes(start2, end2, &newStart2, &newEnd2, ignoreVar, level, 1) ;
-
-    //add not gates if invert is 1
-    if(newStart2 != NULL) {
-      tmpNumNots+=2 ;
-
-      Cube *not1 = (Cube*)malloc(sizeof(Cube)) ;
-      Cube *not2 = (Cube*)malloc(sizeof(Cube)) ;
-      
-      memset(not1, 0, sizeof(Cube)) ;
-      memset(not2, 0, sizeof(Cube)) ;
-      not1->fMark = 1 ;
-      not2->fMark = 1 ;
-      
-      not1->pCubeDataIn = (word*)malloc(sizeof(int)) ;
-      not2->pCubeDataIn = (word*)malloc(sizeof(int)) ;
-      
-      *((int*)(not1->pCubeDataIn)) = bestVar + 1;
-      *((int*)(not2->pCubeDataIn)) = bestVar + 1;
-      
-      not1->Next = newStart2 ;
-      newStart2->Prev = not1 ;
-      not2->Prev = newEnd2 ;
-      newEnd2->Next = not2 ;
-      
-      newStart2 = not1 ;
-      newEnd2 = not2 ;
-    }
+    _reorderCubes(start, mid, ignoreVar, level, 0, pCnt1, pFree) ;
 
+    //add not gates around the second list
+    if(mid < stop) {
+      s_pGates[s_nGates++] = GATE_NOT(bestVar) ;
+      _reorderCubes(mid, stop, ignoreVar, level, 1, pCnt2, pFree) ;
+      s_pGates[s_nGates++] = GATE_NOT(bestVar) ;
+    }
   }
   else {
-    _reorderCubes(start1, end1, &newStart1, &newEnd1, ignoreVar, level, 2) ;
-    _reorderCubes(start2, end2, &newStart2, &newEnd2, ignoreVar, level, 2) ;
+    _reorderCubes(start, mid, ignoreVar, level, 2, pCnt1, pFree) ;
+    _reorderCubes(mid, stop, ignoreVar, level, 2, pCnt2, pFree) ;
   }
 
   //unset ignoreVar[bestVar] to false
   ignoreVar[bestVar] = 0 ;
   (*level)++ ;
-
-  //reconnect the two lists
-  connectLists(newStart1, newStart2, newEnd1, newEnd2, newStart, newEnd) ;
 }
 
-void reorderCubes() {
-  char *ignoreVar = (char*)malloc(sizeof(char)*g_Func.nInputs) ;
-  memset(ignoreVar, 0, sizeof(char)*g_Func.nInputs) ;
-  int bestVar ;
-  float cost ;
-  Cube *start = IterCubeSetStart( ) ;
-  Cube *end = 0 ;
-  Cube *newStart = 0 ;
-  Cube *newEnd = 0  ;
+int reorderCubes() {
+  //fills the gate buffer with the reordered cubes and the "not" gates;
+  //the cover itself is not changed, so this can be called many times
+  //returns 0 if memory cannot be allocated
+  char *ignoreVar ;
   int level = g_Func.nInputs ;
   int invert = 0 ;
+  int k ;
 
-  fprintf(stderr, "reordering cubes\n") ;
+  if(!ReorderArenaPrepare()) {
+    return 0 ;
+  }
+  ignoreVar = s_pIgnoreVar ;
+  memset(ignoreVar, 0, sizeof(char)*g_Func.nInputs) ;
+  for(k=0 ; k<s_nCubes ; k++) {
+    s_pPerm[k] = k ;
+  }
+  s_nGates = 0 ;
 
   if(!hasNots) {
     invert = 2; 
@@ -404,7 +483,11 @@ void reorderCubes() {
 
   long clk = clock() ;
 
-  _reorderCubes(start, end, &newStart, &newEnd, ignoreVar, &level, invert) ;
+  if(level > 0) {
+    countVars(0, s_nCubes, s_pCounters, s_pCounters+g_Func.nInputs) ;
+  }
+  _reorderCubes(0, s_nCubes, ignoreVar, &level, invert, s_pCounters, s_pCounters+2*g_Func.nInputs) ;
+  assert(s_nGates <= s_nGatesAlloc) ;
 
   reorderTicks = clock() - clk ;
   
@@ -413,288 +496,138 @@ void reorderCubes() {
 
   notRemovalTicks = 0 ;
 
-  fprintf(stderr, "tmpNumNots: %d\n", tmpNumNots) ;
-
   if(hasNots && removeNots) {
 
     clk = clock() ;
 
-    typedef struct sNotChain {
-      Cube *cube ;
-      int isNot ; //else its a representaive for dependent gates
-      struct sNotChain *prev ;
-      struct sNotChain *next ;
-    } NotChain ;
-
-    //remove unneeded nots
-    Cube *cube ;
-
-    NotChain **notChain = (NotChain**)malloc(sizeof(NotChain*)*g_Func.nInputs) ;
-    //Josh Rendon: 4/29/15
-    //Fixed bug where memset was corrupting heap
-    //on incorrectly specified sizeof(NotChain) instead of
-    //sizeof(NotChain*)
-    memset(notChain, 0, sizeof(NotChain*)*g_Func.nInputs) ;
-
-    for(cube = newStart ; cube!=NULL ;cube=cube->Next) {
-
-      if(cube->fMark==1) { //if cube is a "not" cube
-	int line = *((int*)cube->pCubeDataIn)-1 ;
-	if(notChain[line]==0) {
-	  fprintf(stderr, "start notChain %d\n", line) ;
-	  //NotChain *nc = (NotChain*)malloc(sizeof(NotChain)) ;
-	  NotChain *nc = malloc(sizeof(NotChain) ) ;
-          assert(nc != 0);
-	  nc->next = 0 ;
-	  nc->prev = 0 ;
-	  nc->isNot = 1 ;
-	  nc->cube = cube ;
-	  notChain[line] = nc ;
+    //two "not" gates on a line cancel if no gate in between uses the line
+    //as a control; a "not" gate is pending on its line until such a gate
+    //appears (then it is kept) or the next "not" gate on the line appears
+    //(then both are removed); the pending "not" gates at the end are removed
+    int *notPos = s_pNotPos ;
+    word *notMask = s_pNotMask ;
+    word Data, Lits ;
+    int g, v, w, line ;
+
+    for ( v = 0; v < g_Func.nInputs; v++ ) {
+      notPos[v] = -1 ;
+    }
+    memset(notMask, 0, sizeof(word)*g_CoverInfo.nWordsIn) ;
+
+    for(g = 0 ; g < s_nGates ; g++) {
+      if(GATE_IS_NOT(s_pGates[g])) {
+	line = GATE_LINE(s_pGates[g]) ;
+	if(notPos[line] >= 0) {
+	  //	  fprintf(stderr, "line %d: remove nots\n", line) ;
+	  s_pGates[notPos[line]] = GATE_NONE ;
+	  s_pGates[g] = GATE_NONE ;
+	  notPos[line] = -1 ;
 	}
 	else {
-	  //if last in chain is a dependent representative, then cannot got rid of that last or current not gate
-	  if(notChain[line]->isNot) {
-	    //	    fprintf(stderr, "line %d: remove nots\n", line) ;
-	    //can get rid of this and last not gate
-	    //remove prev from the not chain
-	    NotChain *prevPrev = notChain[line]->prev ;
-	    NotChain *prev = notChain[line] ;
-	    notChain[line] = prevPrev ;
-	    //remove the not cubes from the cube list
-	    
-	    Cube *pcube ;
-	    pcube = prev->cube ;
-	    pcube->Prev->Next = pcube->Next ;
-	    pcube->Next->Prev = pcube->Prev ;
-
-	    free(pcube) ;
-	    tmpNumNots-- ;
-
-	    pcube = cube ;
-	    pcube->Prev->Next = pcube->Next ;
-	    pcube->Next->Prev = pcube->Prev ;
-
-	    //set cube to be cube->Prev ;
-	    cube = cube->Prev ;
-	    
-	    free(pcube) ;
-	    tmpNumNots-- ;
-	  }
-	  else {
-	    //add new not gate
-	    //	    fprintf(stderr, "line %d: keep nots\n", line) ;
-	    NotChain *nc = (NotChain*)malloc(sizeof(NotChain)) ;
-	    nc->next = 0 ;
-	    nc->prev = notChain[line] ;
-	    nc->isNot = 1 ;
-	    nc->cube = cube ;
-	    notChain[line]->next = nc ;
-	    notChain[line] = nc ;
-	  }
+	  notPos[line] = g ;
 	}
+	notMask[VarWord(line<<1)] ^= ((word)1) << VarBit(line<<1) ;
       }
-      else {
-	//check all control lines
-	//mark notFound[line] = 2 if notFound[line] == 1 
-	int v ;
-	for ( v = 0; v < g_Func.nInputs; v++ ) {
-	  int Value = GetVar( cube, v );
-	  if ( Value == VAR_NEG || Value == VAR_POS) {
-	    if(notChain[v]!=0) {
-	      if(notChain[v]->isNot) {
-		//		fprintf(stderr, "line %d: set dependent\n", v) ;
-		//add new dependent representative
-		NotChain *nc = (NotChain*)malloc(sizeof(NotChain)) ;
-		nc->next = 0 ;
-		nc->prev = notChain[v] ;
-		nc->isNot = 0 ;
-		nc->cube = cube ;
-		notChain[v]->next = nc ;
-		notChain[v] = nc ;
-	      }
+      else if(s_pGates[g] != GATE_NONE) {
+	//the control lines of the cube with a pending "not" gate keep it
+	Cube *cube = s_pCubes[s_pGates[g]] ;
+	for(w=0 ; w<g_CoverInfo.nWordsIn ; w++) {
+	  Data = cube->pCubeDataIn[w] ;
+	  //the literals have the value VAR_NEG or VAR_POS
+	  Lits = (Data ^ (Data>>1)) & DIFFERENT & notMask[w] ;
+	  if(Lits == 0) {
+	    continue ;
+	  }
+	  notMask[w] ^= Lits ;
+	  for(v = w*(BPI/2) ; Lits ; v++, Lits>>=2) {
+	    if(Lits&1) {
+	      //	      fprintf(stderr, "line %d: set dependent\n", v) ;
+	      notPos[v] = -1 ;
 	    }
 	  }
-	}	
+	}
       }
     }
 
     //remove the nots that are at the end and are not needed
-    int v ; 
     for ( v = 0; v < g_Func.nInputs; v++ ) {
-      if(notChain[v] != 0) {
-	if(notChain[v]->isNot) {
-	  //remove the not
-	  //	  fprintf(stderr, "line %d: remove end not\n", v) ;
-	  //can get rid of end not gate
-	  Cube *cube = notChain[v]->cube ;
-	  cube->Prev->Next = cube->Next ;
-	  if(cube->Next) {
-	    cube->Next->Prev = cube->Prev ;
-	  }
-
-	  free(cube) ;
-	  tmpNumNots-- ;
-	}
+      if(notPos[v] >= 0) {
+	//	fprintf(stderr, "line %d: remove end not\n", v) ;
+	s_pGates[notPos[v]] = GATE_NONE ;
       }
     }
 
     notRemovalTicks = clock() - clk ;
 
   }
-  
 
-  s_List = newStart ;
-  s_pCubeLast = NULL ;
-
-  free(ignoreVar) ;
+  return 1 ;
 }
 
-void printToffoliGate(FILE *tfile, Cube *cube, int *pcontrol, int *target) {
-  int v ;
-  int w ; 
-  int cOutputs;
-  int nOutput;
-  int WordSize;
-
-  if(cube->fMark) {
-    numNots++ ;
-    fprintf(tfile, "T1 x%d\n", *((int*)cube->pCubeDataIn)-1) ;
+int ComputeCascade(tcascade *pCas) {
+  //reorders the cubes and puts the resulting gates into the cascade;
+  //each cube gives one gate for each of its outputs; the control lines
+  //of the cube are its literals with the "not" gates, otherwise the
+  //positive literals are the lines v and the negative ones nInputs+v
+  //returns 0 if memory cannot be allocated
+  int nLinesIn = hasNots ? g_Func.nInputs : 2*g_Func.nInputs ;
+  word *pMask ;
+  word Data, Neg, Pos ;
+  Cube *cube ;
+  int g, w, v, nControls ;
+
+  if(!reorderCubes()) {
+    return 0 ;
   }
-  else {
-    // get the input vars
-    int numPControl = 0 ;
+  CascadeRestart(pCas, nLinesIn, g_Func.nOutputs) ;
+  pMask = s_pMask ;
 
-    //zero out pcontrol
-    for ( v = 0; v < g_Func.nInputs*2; v++ ) {
-      pcontrol[v] = 0 ;
+  for(g = 0 ; g < s_nGates ; g++) {
+    if(GATE_IS_NOT(s_pGates[g])) {
+      if(!CascadeAddGate(pCas, NULL, 0, GATE_LINE(s_pGates[g]))) {
+	return 0 ;
+      }
+      continue ;
     }
-    //zero out target
-    for ( w = 0; w < g_Func.nOutputs; w++ ) {
-      target[w] = 0 ;
+    if(s_pGates[g] == GATE_NONE) {
+      continue ;
     }
-
-    for ( v = 0; v < g_Func.nInputs; v++ ) {
-      int Value = GetVar( cube, v );
-      
+    //derive the control mask from the cube words
+    cube = s_pCubes[s_pGates[g]] ;
+    memset(pMask, 0, sizeof(word)*pCas->nWords) ;
+    nControls = 0 ;
+    for(w=0 ; w<g_CoverInfo.nWordsIn ; w++) {
+      Data = cube->pCubeDataIn[w] ;
+      Neg = Data & ~(Data>>1) & DIFFERENT ;
+      Pos = (Data>>1) & ~Data & DIFFERENT ;
       if(hasNots) {
-	//means to use the positive literal
-	if ( Value == VAR_POS || Value == VAR_NEG) {
-	  //	fprintf( stdout, "1" );
-	  pcontrol[v] = 1 ;
-	  pcontrol[g_Func.nInputs+v] = 0 ;
-	  numPControl++ ;
-	}
-	else if ( Value == VAR_ABS ) {
-	  //	fprintf( stdout, "-" );
-	  pcontrol[v] = 0 ;
-	  pcontrol[g_Func.nInputs+v] = 0 ;
-	}
-	else {
-	  assert(0);
-	}
+	Pos |= Neg ;
+	Neg = 0 ;
       }
-      else {
-	if ( Value == VAR_NEG ) {
-	  //	fprintf( stdout, "0" );
-	  pcontrol[v] = 0 ;
-	  pcontrol[g_Func.nInputs+v] = 1 ;
-	  numPControl++ ;
-	}
-	else if ( Value == VAR_POS ) {
-	  //	fprintf( stdout, "1" );
-	  pcontrol[v] = 1 ;
-	  pcontrol[g_Func.nInputs+v] = 0 ;
-	  numPControl++ ;
+      for(v = w*(BPI/2) ; Pos|Neg ; v++, Pos>>=2, Neg>>=2) {
+	if(Pos&1) {
+	  pMask[v/BPI] |= ((word)1) << (v%BPI) ;
+	  nControls++ ;
 	}
-	else if ( Value == VAR_ABS ) {
-	  //	fprintf( stdout, "-" );
-	  pcontrol[v] = 0 ;
-	  pcontrol[g_Func.nInputs+v] = 0 ;
-	}
-	else {
-	  assert(0);
+	else if(Neg&1) {
+	  pMask[(g_Func.nInputs+v)/BPI] |= ((word)1) << ((g_Func.nInputs+v)%BPI) ;
+	  nControls++ ;
 	}
       }
     }
-    //fprintf( stdout, " " );
-    
-    // write the output variables
-    cOutputs = 0;
-    nOutput = g_Func.nOutputs;
-    WordSize = 8*sizeof( unsigned );
-    for ( w = 0; w < g_CoverInfo.nWordsOut; w++ ) {
-      for ( v = 0; v < WordSize; v++ ) {
-	if ( cube->pCubeDataOut[w] & (1<<v) ) {
-	  //	  fprintf( stdout, "1" );
-	  target[v] = 1 ;
-	}
-	else {
-	  //	  fprintf( stdout, "0" );
-	  target[v] = 0 ;
-	}
-	if ( ++cOutputs == nOutput ) {
-	  break;
-	}
-      }
-    }
-    //    fprintf( stdout, "\n" );
-
     for(w=0 ; w<g_Func.nOutputs ; w++) {
-      if(target[w]==1) {
-	numGates++ ;
-	fprintf(tfile, "T%d ", numPControl+1) ;
-	if(hasNots) {
-	  for(v=0 ; v<g_Func.nInputs; v++) {
-	    if(pcontrol[v]==1) {
-	      fprintf(tfile, "x%d,", v) ;
-	    }
-	  }
-	}
-	else {
-	  for(v=0 ; v<g_Func.nInputs*2; v++) {
-	    if(pcontrol[v]==1) {
-	      fprintf(tfile, "x%d,", v) ;
-	    }
-	  }
+      if(cube->pCubeDataOut[w/BPI] & ((word)1<<(w%BPI))) {
+	if(!CascadeAddGate(pCas, pMask, nControls, nLinesIn+w)) {
+	  return 0 ;
 	}
-	fprintf(tfile, "f%d\n", w) ;
       }
     }
   }
+  return 1 ;
 }
 
-void WriteToffoli()
-// nCubesAlloc is the number of allocated cubes 
-{
-  int v, w;
-  Cube * p;
-
-  
-  int *pcontrol = (int*)malloc(sizeof(int)*g_Func.nInputs*2) ;
-  int *target = (int*)malloc(sizeof(int)*g_Func.nOutputs) ;
-  int numPControl = 0 ;
-  
-  FILE *tfile ;
-  char tfilename[1024] ;
-
-  reorderCubes() ;
-
-  fprintf(stderr, "tmpNumNots: %d\n", tmpNumNots) ;
-
-  fprintf(stderr, "writing toffoli list\n") ;
-  
-  sprintf(tfilename, "%s.tfc", g_Func.FileInput) ;
-  
-  fprintf(stderr, "file: %s\n", tfilename) ;
-
-  fprintf(stderr, "output file: %s\n", tfilename) ;
-
-  tfile = fopen(tfilename, "w") ;
-
-  if(!tfile) {
-    fprintf(stderr, "can't open %s...quitting\n", tfilename) ;
-    return ; 
-  }
+void printTfcHeader(FILE *tfile) {
+  int v, w ;
 
   //output statistics
   fprintf(tfile, "#NOTE:  two sets of stats, one at the top of the file, the other at the end of file\n") ;
@@ -702,7 +635,7 @@ void WriteToffoli()
   fprintf(tfile, "#second set are the toffoli cascade generation stats\n") ;
   fprintf(tfile, "#\n") ;
   fprintf(tfile, "#StatSetOne format: #. name in out cubes\n") ;
-  fprintf(tfile, "#StatTwoOne format: #. gates nots esopTime reorderTime notRemovalTime totalToffoliTime totalTime\n") ;
+  fprintf(tfile, "#StatTwoOne format: #. gates nots esopTime reorderTime notRemovalTime totalToffoliTime totalTime gatesBefore notsBefore qcostBefore qcost peepholeTime lines depth\n") ;
   fprintf(tfile, "#\n") ;
   fprintf(tfile, "#StatSetOne\n") ;
   fprintf(tfile, "#. %s %d %d %d\n",
@@ -712,8 +645,6 @@ void WriteToffoli()
 	  g_CoverInfo.nCubesInUse) ;
 
 
-  long clk1 = clock();
-
   //output .v line
   fprintf(tfile, ".v ") ;
   if(hasNots) {
@@ -769,66 +700,164 @@ void WriteToffoli()
   }
   //output BEGIN
   fprintf(tfile, "\nBEGIN\n") ;
-  
-  for ( p = IterCubeSetStart( ); p; p = IterCubeSetNext() ) {
-    //assert( p->fMark == 0 );  //fMark == 0 means its a toffoli not gate
-    printToffoliGate(tfile, p, pcontrol, target) ;
-    if(p->fMark) {
-      //remove the "not" cube
-      Cube *prev = p->Prev ;
-      Cube *next = p->Next ;
-      free((int*)(p->pCubeDataIn)) ;
-      tmpNumNots-- ;
-      if(prev) {
-	prev->Next = next ;
-	if(next) {
-	  next->Prev = prev ;
-	}
-      }
-      else if(next) {
-	next->Prev = 0 ;
-      }
-      free(p) ;
-      if(prev) {
-	p = prev ;
-      }
-      else if(next) {
-	p = next ;
-      }
-      else {
-	s_List = NULL ;
-	s_pCubeLast = NULL ;
-      }
-    }
+}
+
+int VerifyCascade(tcascade *pCas)
+// compares the outputs of the cascade with the output bdds of the function;
+// returns 1 if the cascade is correct
+{
+  long clk = clock() ;
+  int RetValue ;
+
+  if(g_CoverInfo.Verify == 2) {
+    RetValue = CascadeVerifyBdd(pCas, g_Func.dd, g_Func.pOutputs, g_Func.nInputs) ;
+  }
+  else {
+    RetValue = CascadeVerifySim(pCas, g_Func.dd, g_Func.pOutputs, g_Func.nInputs) ;
+  }
+  if(RetValue == -1) {
+    fprintf(stderr, "Unexpected memory allocation problem. Quitting...\n") ;
+    return 0 ;
+  }
+  if(RetValue == 0) {
+    printf("Verification of the Toffoli cascade is not okay\n") ;
+  }
+  else if(g_CoverInfo.Verbosity) {
+    printf("Verification of the Toffoli cascade: okay for all outputs\n") ;
+    printf("Verification time      = %.2f sec\n", TICKS_TO_SECONDS(clock() - clk)) ;
+  }
+  return RetValue ;
+}
+
+int WriteToffoli(char *tfilename, tstats *pStats)
+// writes the Toffoli cascade for the current cover into the file
+// and its statistics into pStats (if given); returns 1 on success,
+// 0 if the cascade is not written (e.g. because it fails verification)
+{
+  FILE *tfile ;
+  char *mfilename ;
+  long numGatesBefore, numNotsBefore ;
+  double qCostBefore ;
+  tmetrics Metrics ;
+  tstats Stats ;
+  long clk ;
+
+  if(s_pCascade == NULL) {
+    s_pCascade = CascadeAlloc(0, 0) ;
+  }
+  if(s_pCascade == NULL || !ComputeCascade(s_pCascade)) {
+    fprintf(stderr, "Unexpected memory allocation problem. Quitting...\n") ;
+    return 0 ;
+  }
+  numNotsBefore = CascadeCountNots(s_pCascade) ;
+  numGatesBefore = s_pCascade->nGates - numNotsBefore ;
+  qCostBefore = CascadeQuantumCost(s_pCascade) ;
+
+  //remove the gates that cancel
+  clk = clock() ;
+  if(optimizeGates && CascadeOptimize(s_pCascade) == -1) {
+    fprintf(stderr, "Unexpected memory allocation problem. Quitting...\n") ;
+    return 0 ;
+  }
+  peepholeTicks = clock() - clk ;
+  numNots = CascadeCountNots(s_pCascade) ;
+  numGates = s_pCascade->nGates - numNots ;
+
+  //the output bdds are still available, so the cascade is checked before writing;
+  //a wrong cascade is not written
+  if(g_CoverInfo.Verify && !VerifyCascade(s_pCascade)) {
+    printf("The Toffoli cascade is not written into file %s\n", tfilename) ;
+    return 0 ;
   }
 
-  fprintf(tfile, "END\n") ;
+  if(g_CoverInfo.Verbosity) {
+    printf("Writing the Toffoli cascade into file %s\n", tfilename) ;
+  }
 
-  fprintf(stderr, "tmpNumNots: %d , numNots: %ld\n", tmpNumNots, numNots) ;
+  tfile = fopen(tfilename, fBinaryTfc ? "wb" : "w") ;
 
-  long ticks = clock() - clk1;  //note that this includes file write time
+  if(!tfile) {
+    fprintf(stderr, "can't open %s...quitting\n", tfilename) ;
+    return 0 ; 
+  }
+
+  //the metrics are collected while the gates are written
+  if(!MetricsStart(&Metrics, s_pCascade)) {
+    fprintf(stderr, "Unexpected memory allocation problem. Quitting...\n") ;
+    fclose(tfile) ;
+    return 0 ;
+  }
+  if(fBinaryTfc) {
+    CascadeWriteBinary(s_pCascade, tfile, &Metrics) ;
+  }
+  else {
+    printTfcHeader(tfile) ;
+    CascadeWriteTfcGates(s_pCascade, tfile, &Metrics) ;
+  }
+  MetricsStop(&Metrics) ;
 
   float esopTime = TICKS_TO_SECONDS(g_CoverInfo.TimeRead) + TICKS_TO_SECONDS(g_CoverInfo.TimeStart) + TICKS_TO_SECONDS(g_CoverInfo.TimeMin);
   float reorderTime = TICKS_TO_SECONDS(reorderTicks) ;
   float notRemovalTime = TICKS_TO_SECONDS(notRemovalTicks) ;
-  float toffoliTime = reorderTime+notRemovalTime ;
+  float peepholeTime = TICKS_TO_SECONDS(peepholeTicks) ;
+  float toffoliTime = reorderTime+notRemovalTime+peepholeTime ;
   float totalTime = esopTime + toffoliTime ;
-  fprintf(tfile, "#\n") ;
-  //  fprintf(tfile, "#StatTwoOne format: #. gates nots esopTime reorderTime notRemovalTime totalToffoliTime totalTime\n") ;
-  fprintf(tfile, "#StatSetTwo\n") ;
-  fprintf(tfile, "#. %ld %ld %.2f %.2f %.2f %.2f %.2f\n",
-	  numGates, 
-	  numNots, 
-	  esopTime,
-	  reorderTime,
-	  notRemovalTime, 
-	  toffoliTime,
-	  totalTime) ;
-	  
-  //  fclose(tfile) ;
-
-  free(pcontrol) ;
-  free(target) ;
+  if(!fBinaryTfc) {
+    fprintf(tfile, "END\n") ;
+    fprintf(tfile, "#\n") ;
+    //  fprintf(tfile, "#StatTwoOne format: #. gates nots esopTime reorderTime notRemovalTime totalToffoliTime totalTime\n") ;
+    fprintf(tfile, "#StatSetTwo\n") ;
+    fprintf(tfile, "#. %ld %ld %.2f %.2f %.2f %.2f %.2f %ld %ld %.0f %.0f %.2f %d %d\n",
+	    numGates, 
+	    numNots, 
+	    esopTime,
+	    reorderTime,
+	    notRemovalTime, 
+	    toffoliTime,
+	    totalTime,
+	    numGatesBefore,
+	    numNotsBefore,
+	    qCostBefore,
+	    Metrics.qCost,
+	    peepholeTime,
+	    Metrics.nLines,
+	    Metrics.Depth) ;
+  }
+  fclose(tfile) ;
+
+  //keep the statistics for the batch mode and the metrics file
+  Stats.nVarsIn = g_CoverInfo.nVarsIn ;
+  Stats.nVarsOut = g_CoverInfo.nVarsOut ;
+  Stats.nCubes = g_CoverInfo.nCubesInUse ;
+  Stats.nGates = numGates ;
+  Stats.nNots = numNots ;
+  Stats.nGatesBefore = numGatesBefore ;
+  Stats.nNotsBefore = numNotsBefore ;
+  Stats.qCostBefore = qCostBefore ;
+  Stats.qCost = Metrics.qCost ;
+  Stats.nLines = Metrics.nLines ;
+  Stats.Depth = Metrics.Depth ;
+  Stats.esopTime = esopTime ;
+  Stats.reorderTime = reorderTime ;
+  Stats.notRemovalTime = notRemovalTime ;
+  Stats.peepholeTime = peepholeTime ;
+  Stats.toffoliTime = toffoliTime ;
+  Stats.totalTime = totalTime ;
+  Stats.fStopped = g_CoverInfo.fStop ;
+  if(pStats) {
+    *pStats = Stats ;
+  }
+
+  //write the metrics next to the TFC file
+  if(fMetricsFile) {
+    mfilename = ALLOC(char, strlen(tfilename) + 6) ;
+    sprintf(mfilename, "%s.json", tfilename) ;
+    if(!MetricsWriteFile(&Metrics, &Stats, mfilename)) {
+      fprintf(stderr, "can't open %s...\n", mfilename) ;
+    }
+    FREE(mfilename) ;
+  }
+  return 1 ;
 }
 
 void WriteTableIntoFile( FILE * pFile )
@@ -840,8 +869,6 @@ void WriteTableIntoFile( FILE * pFile )
 	int nOutput;
 	int WordSize;
 
-	WriteToffoli() ;
-
 	fprintf(stderr, "WriteTableIntoFile\n") ;
 
 	for ( p = IterCubeSetStart( ); p; p = IterCubeSetNext() )
@@ -866,11 +893,11 @@ void WriteTableIntoFile( FILE * pFile )
 		// write the output variables
 		cOutputs = 0;
 		nOutput = g_Func.nOutputs;
-		WordSize = 8*sizeof( unsigned );
+		WordSize = BPI;
 		for ( w = 0; w < g_CoverInfo.nWordsOut; w++ )
 			for ( v = 0; v < WordSize; v++ )
 			{
-				if ( p->pCubeDataOut[w] & (1<<v) )
+				if ( p->pCubeDataOut[w] & ((word)1<<v) )
 					fprintf( pFile, "1" );
 				else
 					fprintf( pFile, "0" );
@@ -886,11 +913,75 @@ void WriteTableIntoFile( FILE * pFile )
 }
 
   
+int SweepPoints()
+// returns the number of the points of the sweep (one point without the sweep):
+// the point 0 uses the cost function 0, which does not depend on alpha and beta,
+// the points 1, ..., nSweep use the cost function 1 with alpha = 0, ..., (nSweep-1)/nSweep
+{
+	return (nSweep > 1)? nSweep + 1 : 1;
+}
+
+void SweepSetPoint( int Point )
+// sets the cost function, alpha and beta of the given point of the sweep
+{
+	if ( nSweep <= 1 )
+		return;
+	costFunc = (Point > 0);
+	if ( Point == 0 )
+		return;
+	alphaC = (float)(Point - 1) / nSweep;
+	betaC  = 1 - alphaC;
+}
+
 int WriteResultIntoFile()
 // write the ESOP cover into the PLA file <NewFileName>
+// returns 0 on success, 1 if a Toffoli cascade has not been written
 {
+	char FileName[1024];
+	char * pFileBase, * pExt;
+	double Power;
+	int nDigits, nChars, i;
+
+	// the TFC file name without the extension
+	pFileBase = g_FileTfc ? g_FileTfc : g_Func.FileInput;
+	pExt = fBinaryTfc ? "tfcb" : "tfc";
+
+	if ( nSweep <= 1 )
+	{
+		if ( snprintf( FileName, sizeof(FileName), "%s.%s", pFileBase, pExt ) >= (int)sizeof(FileName) )
+		{
+			printf( "The name of the TFC file of <%s> is too long\n", pFileBase );
+			return 1;
+		}
+		i = WriteToffoli( FileName, g_pStats );
+		ReorderArenaFree();
+		return !i;
+	}
 
-	WriteToffoli() ;
+	// the cascades for all points of the sweep are generated from the same 
+	// minimized cover (the reordering does not change it); the point of the 
+	// cost function 0 is written into <name>.c0.tfc and the points of the cost 
+	// function 1 into <name>.c1.a<alpha>.tfc, where alpha is printed with as many 
+	// digits as needed to keep the names distinct (two digits up to 100 points)
+	for ( nDigits = 2, Power = 100.0; Power < nSweep; nDigits++, Power *= 10 );
+	for ( i = 0; i < SweepPoints(); i++ )
+	{
+		SweepSetPoint( i );
+		if ( i == 0 )
+			nChars = snprintf( FileName, sizeof(FileName), "%s.c0.%s", pFileBase, pExt );
+		else
+			nChars = snprintf( FileName, sizeof(FileName), "%s.c1.a%.*f.%s", pFileBase, nDigits, (double)(i - 1) / nSweep, pExt );
+		if ( nChars >= (int)sizeof(FileName) )
+		{
+			printf( "The name of the TFC file of <%s> is too long\n", pFileBase );
+			break;
+		}
+		if ( !WriteToffoli( FileName, g_pStats ? g_pStats + i : NULL ) )
+			break;
+	}
+	ReorderArenaFree();
+	if ( i < SweepPoints() )
+		return 1;
 
   /*
 	FILE * pFile;
@@ -987,11 +1078,11 @@ void PrintCube( ostream& DebugStream, Cube* pC )
 	// write the output variables
 	int cOutputs = 0;
 	int nOutput = g_CoverInfo.nVarsOut;
-	int WordSize = 8*sizeof( unsigned );
+	int WordSize = BPI;
 	for ( w = 0; w < g_CoverInfo.nWordsOut; w++ )
 		for ( v = 0; v < WordSize; v++ )
 		{
-			if ( pC->pCubeDataOut[w] & (1<<v) )
+			if ( pC->pCubeDataOut[w] & ((word)1<<v) )
 				DebugStream << "1";
 			else
 				DebugStream << "0";
@@ -0,0 +1,313 @@
+////////////////////////////////////////////////////////////////////////
+///                                                                  ///
+///                  Implementation of EXORCISM - 4                  ///
+///              An Exclusive Sum-of-Product Minimizer               ///
+///               Alan Mishchenko  <alanmi@ee.pdx.edu>               ///
+///                                                                  ///
+////////////////////////////////////////////////////////////////////////
+///                                                                  ///
+///                        Verification Module                       ///
+///                                                                  ///
+///      1) bit-parallel simulation of the Toffoli cascade           ///
+///      2) comparison of the simulated outputs with the bdds        ///
+///      3) symbolic equivalence check by composing the gates        ///
+///                                                                  ///
+////////////////////////////////////////////////////////////////////////
+///   This software was tested with the BDD package "CUDD", v.2.3.0  ///
+///                          by Fabio Somenzi                        ///
+///                  http://vlsi.colorado.edu/~fabio/                ///
+////////////////////////////////////////////////////////////////////////
+
+#include "exor.h"
+#include "extra.h"
+#include <string.h>
+
+////////////////////////////////////////////////////////////////////////
+///                      FUNCTIONS OF THIS MODULE                    ///
+////////////////////////////////////////////////////////////////////////
+
+// verifies the cascade by simulation against the output bdds
+int CascadeVerifySim( tcascade * p, DdManager * dd, DdNode ** pOutputs, int nInputs );
+// verifies the cascade by computing the bdds of its output lines
+int CascadeVerifyBdd( tcascade * p, DdManager * dd, DdNode ** pOutputs, int nInputs );
+
+// simulation of the cascade
+static void  CascadeSimAssignInputs( tcascade * p, int nInputs, int fExhaustive );
+static void  CascadeSimulate( tcascade * p );
+static word  CascadeSimRandomWord();
+
+////////////////////////////////////////////////////////////////////////
+///                        STATIC VARIABLES                          ///
+////////////////////////////////////////////////////////////////////////
+
+// the functions with at most this many inputs are simulated exhaustively;
+// otherwise, the given number of random patterns is simulated
+#define CASCADE_SIM_EXHAUSTIVE   16
+#define CASCADE_SIM_RANDOM     4096
+
+// the simulation info of the lines (s_nSimWords words for each line);
+// each bit of the word is one input pattern, so that one pass over
+// the cascade simulates BPI * s_nSimWords patterns
+static word * s_pSims = NULL;
+static word * s_pAnd = NULL;
+// the patterns of the inputs (the input lines are changed by the "not" gates)
+static word * s_pPats = NULL;
+static int s_nSimWords = 0;
+
+// the seed of the random patterns (the same patterns on all platforms)
+static unsigned s_SimSeed = 0;
+
+////////////////////////////////////////////////////////////////////////
+///                      FUNCTION DEFINITIONS                        ///
+////////////////////////////////////////////////////////////////////////
+
+int CascadeVerifySim( tcascade * p, DdManager * dd, DdNode ** pOutputs, int nInputs )
+// simulates the cascade and compares the output lines with the bdds;
+// the input lines of the cascade are the inputs of the bdds, followed
+// by their complements if the cascade has 2 * nInputs input lines;
+// returns 1 if the outputs agree on all patterns, 0 if they do not,
+// and -1 if memory cannot be allocated
+{
+	DdNode * bOne = Cudd_ReadOne( dd );
+	int * pAssign, * pWrong;
+	int fExhaustive, nPats, nWrong;
+	int i, o, Pat;
+	word Value;
+
+	assert( p->nLinesIn == nInputs || p->nLinesIn == 2 * nInputs );
+
+	// determine the number of patterns
+	fExhaustive = ( nInputs <= CASCADE_SIM_EXHAUSTIVE );
+	if ( fExhaustive )
+		nPats = ( (1 << nInputs) < BPI )? BPI: (1 << nInputs);
+	else
+		nPats = CASCADE_SIM_RANDOM;
+	s_nSimWords = nPats / BPI;
+
+	s_pSims = ALLOC( word, p->nLines * s_nSimWords );
+	s_pAnd  = ALLOC( word, s_nSimWords );
+	s_pPats = ALLOC( word, nInputs * s_nSimWords );
+	pAssign = ALLOC( int, Cudd_ReadSize(dd) );
+	pWrong  = ALLOC( int, p->nOutputs );
+	if ( s_pSims == NULL || s_pAnd == NULL || s_pPats == NULL || pAssign == NULL || pWrong == NULL )
+	{
+		FREE( s_pSims );
+		FREE( s_pAnd );
+		FREE( s_pPats );
+		FREE( pAssign );
+		FREE( pWrong );
+		return -1;
+	}
+	memset( pAssign, 0, sizeof(int) * Cudd_ReadSize(dd) );
+	memset( pWrong, 0, sizeof(int) * p->nOutputs );
+
+	// simulate the cascade
+	CascadeSimAssignInputs( p, nInputs, fExhaustive );
+	memcpy( s_pPats, s_pSims, sizeof(word) * nInputs * s_nSimWords );
+	CascadeSimulate( p );
+
+	// compare the output lines with the bdds, one pattern at a time
+	for ( Pat = 0; Pat < nPats; Pat++ )
+	{
+		for ( i = 0; i < nInputs; i++ )
+			pAssign[i] = (int)((s_pPats[i * s_nSimWords + Pat / BPI] >> (Pat % BPI)) & 1);
+		for ( o = 0; o < p->nOutputs; o++ )
+		{
+			Value = (s_pSims[(p->nLinesIn + o) * s_nSimWords + Pat / BPI] >> (Pat % BPI)) & 1;
+			if ( (int)Value != (Cudd_Eval( dd, pOutputs[o], pAssign ) == bOne) )
+				pWrong[o]++;
+		}
+	}
+
+	// report the outputs that do not agree
+	nWrong = 0;
+	for ( o = 0; o < p->nOutputs; o++ )
+		if ( pWrong[o] )
+		{
+			printf( "Simulation of the cascade is not okay for output #%d ", o );
+			printf( "(%d wrong out of %d %s patterns)\n", pWrong[o], nPats, fExhaustive? "exhaustive": "random" );
+			nWrong++;
+		}
+
+	FREE( s_pSims );
+	FREE( s_pAnd );
+	FREE( s_pPats );
+	FREE( pAssign );
+	FREE( pWrong );
+	return (int)( nWrong == 0 );
+}
+
+int CascadeVerifyBdd( tcascade * p, DdManager * dd, DdNode ** pOutputs, int nInputs )
+// derives the bdds of the lines by applying the gates one by one
+// and compares the bdds of the output lines with the given bdds;
+// the conjunction of the controls is reused by the following gates
+// with the same controls (the gates derived from one multi-output cube);
+// returns 1 if the outputs are equivalent, 0 if they are not,
+// and -1 if memory cannot be allocated
+{
+	DdNode ** pbLines, * bAnd, * bTemp, * bDiff;
+	word * pControls, * pPrev, Word;
+	int g, w, i, o, Line, nWrong, RetValue = -1;
+
+	assert( p->nLinesIn == nInputs || p->nLinesIn == 2 * nInputs );
+
+	pbLines = ALLOC( DdNode *, p->nLines );
+	if ( pbLines == NULL )
+		return -1;
+	// the input lines are the variables (or their complements)
+	for ( i = 0; i < p->nLinesIn; i++ )
+	{
+		pbLines[i] = Cudd_NotCond( Cudd_bddIthVar( dd, i % nInputs ), i >= nInputs );
+		Cudd_Ref( pbLines[i] );
+	}
+	// the output lines are zero
+	for ( i = p->nLinesIn; i < p->nLines; i++ )
+	{
+		pbLines[i] = Cudd_ReadLogicZero( dd );
+		Cudd_Ref( pbLines[i] );
+	}
+
+	// apply the gates
+	bAnd = NULL;
+	pPrev = NULL;
+	for ( g = 0; g < p->nGates; g++ )
+	{
+		pControls = CascadeControls( p, g );
+		if ( bAnd == NULL || memcmp( pControls, pPrev, sizeof(word) * p->nWords ) )
+		{
+			// derive the conjunction of the controls
+			if ( bAnd )
+				Cudd_RecursiveDeref( dd, bAnd );
+			bAnd = Cudd_ReadOne( dd );
+			Cudd_Ref( bAnd );
+			for ( w = 0; w < p->nWords; w++ )
+				for ( Word = pControls[w], Line = w * BPI; Word; Word >>= 1, Line++ )
+					if ( Word & 1 )
+					{
+						bAnd = Cudd_bddAnd( dd, bTemp = bAnd, pbLines[Line] );
+						if ( bAnd == NULL )
+						{
+							Cudd_RecursiveDeref( dd, bTemp );
+							goto finish;
+						}
+						Cudd_Ref( bAnd );
+						Cudd_RecursiveDeref( dd, bTemp );
+					}
+			pPrev = pControls;
+		}
+		// the target cannot be one of the controls, so the conjunction stays valid
+		assert( !CascadeHasControl(p, g, p->pTargets[g]) );
+		pbLines[p->pTargets[g]] = Cudd_bddXor( dd, bTemp = pbLines[p->pTargets[g]], bAnd );
+		if ( pbLines[p->pTargets[g]] == NULL )
+		{
+			pbLines[p->pTargets[g]] = bTemp;
+			goto finish;
+		}
+		Cudd_Ref( pbLines[p->pTargets[g]] );
+		Cudd_RecursiveDeref( dd, bTemp );
+	}
+
+	// compare the output lines with the bdds
+	nWrong = 0;
+	for ( o = 0; o < p->nOutputs; o++ )
+		if ( pbLines[p->nLinesIn + o] != pOutputs[o] )
+		{
+			bDiff = Cudd_bddXor( dd, pbLines[p->nLinesIn + o], pOutputs[o] );
+			if ( bDiff == NULL )
+				goto finish;
+			Cudd_Ref( bDiff );
+			printf( "Equivalence check of the cascade is not okay for output #%d ", o );
+			printf( "(%.0f wrong minterms)\n", Cudd_CountMinterm( dd, bDiff, nInputs ) );
+			Cudd_RecursiveDeref( dd, bDiff );
+			nWrong++;
+		}
+	RetValue = (int)( nWrong == 0 );
+
+finish:
+	if ( bAnd )
+		Cudd_RecursiveDeref( dd, bAnd );
+	for ( i = 0; i < p->nLines; i++ )
+		Cudd_RecursiveDeref( dd, pbLines[i] );
+	FREE( pbLines );
+	return RetValue;
+}
+
+static void CascadeSimAssignInputs( tcascade * p, int nInputs, int fExhaustive )
+// sets the simulation info of the input lines; the output lines are zero
+{
+	word * pSim;
+	int i, k, b, Pat;
+
+	s_SimSeed = 0;
+	for ( i = 0; i < nInputs; i++ )
+	{
+		pSim = s_pSims + i * s_nSimWords;
+		if ( fExhaustive )
+		{
+			// the pattern number Pat assigns bit i of Pat to input i
+			for ( k = 0; k < s_nSimWords; k++ )
+				for ( pSim[k] = 0, b = 0; b < BPI; b++ )
+				{
+					Pat = k * BPI + b;
+					if ( (Pat >> i) & 1 )
+						pSim[k] |= ((word)1) << b;
+				}
+		}
+		else
+		{
+			for ( k = 0; k < s_nSimWords; k++ )
+				pSim[k] = CascadeSimRandomWord();
+		}
+	}
+	// the complemented input lines
+	for ( i = nInputs; i < p->nLinesIn; i++ )
+		for ( k = 0; k < s_nSimWords; k++ )
+			s_pSims[i * s_nSimWords + k] = ~s_pSims[(i - nInputs) * s_nSimWords + k];
+	// the output lines
+	memset( s_pSims + p->nLinesIn * s_nSimWords, 0, sizeof(word) * p->nOutputs * s_nSimWords );
+}
+
+static void CascadeSimulate( tcascade * p )
+// applies the gates of the cascade to the simulation info of the lines;
+// the gate without the control lines complements its target line;
+// the loops over the words do not depend on each other, so that the
+// compiler can use the vector instructions of the processor for them
+{
+	word * pControls, * pSim, * pTarget, Word;
+	int g, w, k, Line;
+
+	for ( g = 0; g < p->nGates; g++ )
+	{
+		for ( k = 0; k < s_nSimWords; k++ )
+			s_pAnd[k] = ~((word)0);
+		pControls = CascadeControls( p, g );
+		for ( w = 0; w < p->nWords; w++ )
+			for ( Word = pControls[w], Line = w * BPI; Word; Word >>= 1, Line++ )
+				if ( Word & 1 )
+				{
+					pSim = s_pSims + Line * s_nSimWords;
+					for ( k = 0; k < s_nSimWords; k++ )
+						s_pAnd[k] &= pSim[k];
+				}
+		pTarget = s_pSims + p->pTargets[g] * s_nSimWords;
+		for ( k = 0; k < s_nSimWords; k++ )
+			pTarget[k] ^= s_pAnd[k];
+	}
+}
+
+static word CascadeSimRandomWord()
+// returns the pseudo-random word, 8 bits at a time
+{
+	word Word = 0;
+	int i;
+	for ( i = 0; i < BPI / 8; i++ )
+	{
+		s_SimSeed = s_SimSeed * 1664525 + 1013904223;
+		Word = (Word << 8) | (word)((s_SimSeed >> 16) & 0xff);
+	}
+	return Word;
+}
+
+///////////////////////////////////////////////////////////////////
+////////////              End of File             /////////////////
+///////////////////////////////////////////////////////////////////
@@ -9,6 +9,7 @@
   Description [External procedures included in this module:
 				<ul>
 				<li> Extra_TransferPermute();
+				<li> Extra_zddTransfer();
 				</ul>
 			Internal procedures included in this module:
 				<ul>
@@ -69,6 +70,12 @@ ARGS((DdManager * ddS, DdManager * ddD, DdNode * f, st_table * table, int * Perm
 static DdNode * extraTransferPermute
 ARGS((DdManager * ddS, DdManager * ddD, DdNode * f, int * Permute));
 
+static DdNode * extraZddTransferRecur
+ARGS((DdManager * ddS, DdManager * ddD, DdNode * zF, st_table * table ));
+
+static DdNode * extraZddTransfer
+ARGS((DdManager * ddS, DdManager * ddD, DdNode * zF));
+
 /**Automaticend***************************************************************/
 
 
@@ -107,6 +114,35 @@ DdNode * Extra_TransferPermute( DdManager * ddSource, DdManager * ddDestination,
 }								/* end of Extra_TransferPermute */
 
 
+/**Function********************************************************************
+
+  Synopsis    [Convert a ZDD from a manager to another one.]
+
+  Description [Convert a ZDD from a manager to another one. The ZDD variables 
+  with the same index should be in the same order in the two managers (for 
+  example, when the ZDD variables are derived from the BDD variables using 
+  Cudd_zddVarsFromBddVars() and the BDD variable orders are the same). Returns 
+  a pointer to the ZDD in the destination manager if successful; NULL otherwise.]
+
+  SideEffects [None]
+
+  SeeAlso     [Extra_TransferPermute]
+
+******************************************************************************/
+DdNode * Extra_zddTransfer( DdManager * ddSource, DdManager * ddDestination, DdNode * zF )
+{
+	DdNode *res;
+	do
+	{
+		ddDestination->reordered = 0;
+		res = extraZddTransfer( ddSource, ddDestination, zF );
+	}
+	while ( ddDestination->reordered == 1 );
+	return ( res );
+
+}								/* end of Extra_zddTransfer */
+
+
 /*---------------------------------------------------------------------------*/
 /* Definition of internal functions                                          */
 /*---------------------------------------------------------------------------*/
@@ -278,6 +314,129 @@ extraTransferPermuteRecur(
 
 }								/* end of extraTransferPermuteRecur */
 
+
+/**Function********************************************************************
+
+  Synopsis    [Convert a ZDD from a manager to another one.]
+
+  Description [Convert a ZDD from a manager to another one. Returns a
+  pointer to the ZDD in the destination manager if successful; NULL
+  otherwise.]
+
+  SideEffects [None]
+
+  SeeAlso     [Extra_zddTransfer]
+
+******************************************************************************/
+static DdNode * extraZddTransfer( DdManager * ddS, DdManager * ddD, DdNode * zF )
+{
+	DdNode *res;
+	st_table *table = NULL;
+	st_generator *gen = NULL;
+	DdNode *key, *value;
+
+	table = st_init_table( st_ptrcmp, st_ptrhash );
+	if ( table == NULL )
+		goto failure;
+	res = extraZddTransferRecur( ddS, ddD, zF, table );
+	if ( res != NULL )
+		cuddRef( res );
+
+	/* Dereference all elements in the table and dispose of the table. */
+	gen = st_init_gen( table );
+	if ( gen == NULL )
+		goto failure;
+	while ( st_gen( gen, ( char ** ) &key, ( char ** ) &value ) )
+	{
+		Cudd_RecursiveDerefZdd( ddD, value );
+	}
+	st_free_gen( gen );
+	gen = NULL;
+	st_free_table( table );
+	table = NULL;
+
+	if ( res != NULL )
+		cuddDeref( res );
+	return ( res );
+
+  failure:
+	if ( table != NULL )
+		st_free_table( table );
+	if ( gen != NULL )
+		st_free_gen( gen );
+	return ( NULL );
+
+}								/* end of extraZddTransfer */
+
+
+/**Function********************************************************************
+
+  Synopsis    [Performs the recursive step of Extra_zddTransfer.]
+
+  Description [Performs the recursive step of Extra_zddTransfer.
+  Returns a pointer to the result if successful; NULL otherwise.]
+
+  SideEffects [None]
+
+  SeeAlso     [extraZddTransfer]
+
+******************************************************************************/
+static DdNode * 
+extraZddTransferRecur( 
+  DdManager * ddS, 
+  DdManager * ddD, 
+  DdNode * zF, 
+  st_table * table )
+{
+	DdNode *zT, *zE, *res;
+
+	statLine( ddD );
+
+	/* Trivial cases. */
+	if ( zF == DD_ZERO( ddS ) )
+		return DD_ZERO( ddD );
+	if ( zF == DD_ONE( ddS ) )
+		return DD_ONE( ddD );
+
+	/* Check the cache. */
+	if ( st_lookup( table, ( char * ) zF, ( char ** ) &res ) )
+		return ( res );
+
+	/* Recursive step. */
+	zT = extraZddTransferRecur( ddS, ddD, cuddT( zF ), table );
+	if ( zT == NULL )
+		return ( NULL );
+	cuddRef( zT );
+
+	zE = extraZddTransferRecur( ddS, ddD, cuddE( zF ), table );
+	if ( zE == NULL )
+	{
+		Cudd_RecursiveDerefZdd( ddD, zT );
+		return ( NULL );
+	}
+	cuddRef( zE );
+
+	res = cuddZddGetNode( ddD, zF->index, zT, zE );
+	if ( res == NULL )
+	{
+		Cudd_RecursiveDerefZdd( ddD, zT );
+		Cudd_RecursiveDerefZdd( ddD, zE );
+		return ( NULL );
+	}
+	cuddDeref( zT );
+	cuddDeref( zE );
+	cuddRef( res );
+
+	if ( st_add_direct( table, ( char * ) zF, ( char * ) res ) ==
+		 ST_OUT_OF_MEM )
+	{
+		Cudd_RecursiveDerefZdd( ddD, res );
+		return ( NULL );
+	}
+	return ( res );
+
+}								/* end of extraZddTransferRecur */
+
 /*---------------------------------------------------------------------------*/
 /* Definition of static Functions                                            */
 /*---------------------------------------------------------------------------*/
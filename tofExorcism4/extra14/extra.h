@@ -269,6 +269,8 @@ Extra_bddImageCompute(
 
 /* convert a {A,B}DD from a manager to another with variable remapping */
 EXTERN DdNode * Extra_TransferPermute ARGS((DdManager * ddSource, DdManager * ddDestination, DdNode * f, int * Permute));
+/* convert a ZDD from a manager to another with the same order of the ZDD variables */
+EXTERN DdNode * Extra_zddTransfer ARGS((DdManager * ddSource, DdManager * ddDestination, DdNode * zF));
 
 /*=== bSPFD.c =================================================================*/
 
@@ -629,6 +631,8 @@ EXTERN DdNode *  extraZddSelectDist1Cubes ARGS((DdManager *dd, DdNode * zA, DdNo
 
 /* computes the set of fast ESOP covers for the multi-output function */
 EXTERN int Extra_zddFastEsopCoverArray ARGS((DdManager * dd, DdNode ** bFs, DdNode ** zCs, int nFs));
+/* computes the set of fast ESOP covers using several threads */
+EXTERN int Extra_zddFastEsopCoverArrayParallel ARGS((DdManager * dd, DdNode ** bFs, DdNode ** zCs, int nFs, int nThreads));
 /* computes a fast ESOP cover for the single-output function */
 EXTERN DdNode * Extra_zddFastEsopCover ARGS((DdManager * dd, DdNode * bF, st_table * Visited, int * pnCubes));
 
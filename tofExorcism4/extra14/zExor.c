@@ -11,6 +11,9 @@
 				<li> Extra_zddUnionExor();
 				<li> Extra_zddSupercubes();
 				<li> Extra_zddSelectDist1Cubes();
+				<li> Extra_zddFastEsopCoverArray();
+				<li> Extra_zddFastEsopCoverArrayParallel();
+				<li> Extra_zddFastEsopCover();
 				</ul>
 			Internal procedures included in this module:
 				<ul>
@@ -35,15 +38,33 @@
 #include "util.h"
 #include "cuddInt.h"
 #include "extra.h"
+#include <pthread.h>
 
 /*---------------------------------------------------------------------------*/
 /* Constant declarations                                                     */
 /*---------------------------------------------------------------------------*/
 
+// the smallest shared BDD size (in nodes), for which the fast ESOP covers 
+// are computed by several threads (for smaller BDDs, starting the managers 
+// takes longer than computing the covers)
+#define EXTRA_ESOP_PARALLEL_NODES  20000
+
 /*---------------------------------------------------------------------------*/
 /* Structure declarations                                                     */
 /*---------------------------------------------------------------------------*/
 
+// the task of one thread computing the fast ESOP covers
+typedef struct 
+{
+	DdManager * dd;      // the manager of this thread
+	int         Num;     // the number of this thread
+	int         nFs;     // the total number of functions
+	int *       pOwner;  // for each function, the number of the thread computing it
+	DdNode **   bFs;     // the functions (each in the manager of its thread)
+	DdNode **   zCs;     // the covers (each in the manager of its thread)
+	int *       pnCubes; // the numbers of cubes in the covers
+} extraEsopTask;
+
 /*---------------------------------------------------------------------------*/
 /* Type declarations                                                         */
 /*---------------------------------------------------------------------------*/
@@ -64,6 +85,7 @@
 /*---------------------------------------------------------------------------*/
 
 static DdNode * extraZddFastEsopCover( DdManager * dd, DdNode * bF, st_table * Table );
+static void * extraZddFastEsopCoverThread( void * pArg );
 
 /**Automaticend***************************************************************/
 
@@ -201,6 +223,157 @@ int Extra_zddFastEsopCoverArray( DdManager * dd, DdNode ** bFs, DdNode ** zCs, i
 }
 
 
+/**Function********************************************************************
+
+  Synopsis    [Computes the set of fast ESOP covers using several threads.]
+
+  Description [Same as Extra_zddFastEsopCoverArray() but the covers of 
+  different functions are computed by several threads. Each thread works 
+  in its own manager, which has the same variable order as the given one. 
+  The functions are distributed among the threads before the computation 
+  (the largest BDDs first, each to the least loaded thread) and transferred 
+  into their managers. When the threads are done, the covers are transferred 
+  back. The resulting covers are the same as those computed by one thread.
+  If the memory for the threads or their managers cannot be allocated, 
+  the covers are computed by Extra_zddFastEsopCoverArray().
+  The ZDD variables should be allocated two per each BDD variable using 
+  Cudd_zddVarsFromBddVars().]
+
+  SideEffects []
+
+  SeeAlso     [Extra_zddFastEsopCoverArray]
+
+******************************************************************************/
+int Extra_zddFastEsopCoverArrayParallel( DdManager * dd, DdNode ** bFs, DdNode ** zCs, int nFs, int nThreads )
+{
+	extraEsopTask * pTasks;
+	pthread_t * pThreads;
+	int * pStarted;
+	DdNode ** bFsT, ** zCsT;
+	int * pOwner, * pnCubes, * pSizes, * pOrder, * pLoads;
+	int nCubesTotal, fFailed;
+	int i, k, t, Temp;
+
+	if ( nThreads > nFs )
+		nThreads = nFs;
+	if ( nThreads < 2 || Cudd_SharingSize( bFs, nFs ) < EXTRA_ESOP_PARALLEL_NODES )
+		return Extra_zddFastEsopCoverArray( dd, bFs, zCs, nFs );
+
+	pTasks   = ALLOC( extraEsopTask, nThreads );
+	pThreads = ALLOC( pthread_t, nThreads );
+	pStarted = ALLOC( int, nThreads );
+	pLoads   = ALLOC( int, nThreads );
+	bFsT     = ALLOC( DdNode *, nFs );
+	zCsT     = ALLOC( DdNode *, nFs );
+	pOwner   = ALLOC( int, nFs );
+	pnCubes  = ALLOC( int, nFs );
+	pSizes   = ALLOC( int, nFs );
+	pOrder   = ALLOC( int, nFs );
+	fFailed  = ( pTasks == NULL || pThreads == NULL || pStarted == NULL || pLoads == NULL || bFsT == NULL || 
+		         zCsT == NULL || pOwner == NULL || pnCubes == NULL || pSizes == NULL || pOrder == NULL );
+
+	// start the managers with the same order of BDD and ZDD variables
+	for ( t = 0; !fFailed && t < nThreads; t++ )
+	{
+		pTasks[t].dd      = Cudd_Init( dd->size, 0, CUDD_UNIQUE_SLOTS, CUDD_CACHE_SLOTS, 0 );
+		if ( pTasks[t].dd == NULL )
+		{
+			fFailed = 1;
+			break;
+		}
+		Cudd_ShuffleHeap( pTasks[t].dd, dd->invperm );
+		Cudd_zddVarsFromBddVars( pTasks[t].dd, 2 );
+		pTasks[t].Num     = t;
+		pTasks[t].nFs     = nFs;
+		pTasks[t].pOwner  = pOwner;
+		pTasks[t].bFs     = bFsT;
+		pTasks[t].zCs     = zCsT;
+		pTasks[t].pnCubes = pnCubes;
+		pLoads[t] = 0;
+	}
+
+	// if the threads cannot be prepared, compute the covers in this thread
+	if ( fFailed )
+	{
+		for ( k = 0; k < t; k++ )
+			Cudd_Quit( pTasks[k].dd );
+		FREE( pTasks );
+		FREE( pThreads );
+		FREE( pStarted );
+		FREE( pLoads );
+		FREE( bFsT );
+		FREE( zCsT );
+		FREE( pOwner );
+		FREE( pnCubes );
+		FREE( pSizes );
+		FREE( pOrder );
+		return Extra_zddFastEsopCoverArray( dd, bFs, zCs, nFs );
+	}
+
+	// order the functions by the BDD size (the largest first)
+	for ( i = 0; i < nFs; i++ )
+	{
+		pSizes[i] = Cudd_DagSize( bFs[i] );
+		pOrder[i] = i;
+	}
+	for ( i = 1; i < nFs; i++ )
+		for ( k = i; k > 0 && pSizes[pOrder[k-1]] < pSizes[pOrder[k]]; k-- )
+		{
+			Temp = pOrder[k]; pOrder[k] = pOrder[k-1]; pOrder[k-1] = Temp;
+		}
+
+	// give each function to the least loaded thread and transfer it there
+	for ( i = 0; i < nFs; i++ )
+	{
+		k = pOrder[i];
+		for ( Temp = 0, t = 1; t < nThreads; t++ )
+			if ( pLoads[Temp] > pLoads[t] )
+				Temp = t;
+		pOwner[k] = Temp;
+		pLoads[Temp] += pSizes[k];
+		bFsT[k] = Extra_TransferPermute( dd, pTasks[Temp].dd, bFs[k], NULL );  Cudd_Ref( bFsT[k] );
+	}
+
+	// compute the covers (if a thread cannot be started, do its task here)
+	for ( t = 0; t < nThreads; t++ )
+	{
+		pStarted[t] = (int)( pthread_create( pThreads + t, NULL, extraZddFastEsopCoverThread, pTasks + t ) == 0 );
+		if ( !pStarted[t] )
+			extraZddFastEsopCoverThread( pTasks + t );
+	}
+	for ( t = 0; t < nThreads; t++ )
+		if ( pStarted[t] )
+			pthread_join( pThreads[t], NULL );
+
+	// transfer the covers back
+	nCubesTotal = 0;
+	for ( i = 0; i < nFs; i++ )
+	{
+		zCs[i] = Extra_zddTransfer( pTasks[pOwner[i]].dd, dd, zCsT[i] );  Cudd_Ref( zCs[i] );
+		Cudd_RecursiveDerefZdd( pTasks[pOwner[i]].dd, zCsT[i] );
+		Cudd_RecursiveDeref( pTasks[pOwner[i]].dd, bFsT[i] );
+		nCubesTotal += pnCubes[i];
+	}
+
+	// stop the managers
+	for ( t = 0; t < nThreads; t++ )
+		Cudd_Quit( pTasks[t].dd );
+
+	FREE( pTasks );
+	FREE( pThreads );
+	FREE( pStarted );
+	FREE( pLoads );
+	FREE( bFsT );
+	FREE( zCsT );
+	FREE( pOwner );
+	FREE( pnCubes );
+	FREE( pSizes );
+	FREE( pOrder );
+	return nCubesTotal;
+
+} /* end of Extra_zddFastEsopCoverArrayParallel */
+
+
 /**Function********************************************************************
 
   Synopsis    [Computes the fast ESOP cover for the function.]
@@ -842,6 +1015,37 @@ DdNode* extraZddSelectDist1Cubes(
 /* Definition of static functions                                            */
 /*---------------------------------------------------------------------------*/
 
+/**Function********************************************************************
+
+  Synopsis    [Computes the fast ESOP covers of the functions of one thread.]
+
+  Description [The thread uses only its own manager and the entries of the 
+  shared arrays that belong to its functions.]
+
+  SideEffects []
+
+  SeeAlso     [Extra_zddFastEsopCoverArrayParallel]
+
+******************************************************************************/
+static void * extraZddFastEsopCoverThread( void * pArg )
+{
+	extraEsopTask * p = (extraEsopTask *)pArg;
+	st_table * Table;
+	int i;
+
+	// the hash-table is shared by the functions of this thread
+	Table = st_init_table(st_ptrcmp,st_ptrhash);
+	for ( i = 0; i < p->nFs; i++ )
+		if ( p->pOwner[i] == p->Num )
+		{
+			p->zCs[i] = Extra_zddFastEsopCover( p->dd, p->bFs[i], Table, p->pnCubes + i ); Cudd_Ref( p->zCs[i] );
+		}
+	st_free_table( Table );
+	return NULL;
+
+} /* end of extraZddFastEsopCoverThread */
+
+
 /**Function********************************************************************
 
   Synopsis    [Performs the recursive step of Extra_zddFastEsopCover.]